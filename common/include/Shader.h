@@ -7,6 +7,11 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
 
 //GLAD
 #include <glad/glad.h>
@@ -14,15 +19,19 @@
 // GLFW
 #include <GLFW/glfw3.h>
 
+#include "gl-stats.h"
+
 using namespace std;
 
 class Shader
 {
 public:
 	GLuint ID;
-	// Constructor generates the shader on the fly
-	Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
+	// Constructor generates the shader on the fly. `defines` (e.g. "#define TEXTURED\n")
+	// is inserted right after the #version line of both stages
+	Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::string& defines = "")
 	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 		// 1. Retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
 		std::string fragmentCode;
@@ -51,12 +60,145 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+
+		if (!defines.empty())
+		{
+			vertexCode = injectDefines(vertexCode, defines);
+			fragmentCode = injectDefines(fragmentCode, defines);
+		}
+
+		build(vertexCode, fragmentCode);
+		loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Enables the on-disk program binary cache (disabled while empty). Programs
+	// are stored by a hash of their sources plus the driver's vendor, renderer
+	// and version strings, so a driver update simply misses the cache.
+	static void setBinaryCacheDirectory(const std::string& directory)
+	{
+		binaryCacheDirectory() = directory;
+		if (!directory.empty())
+		{
+			mkdir(directory.c_str(), 0755);
+		}
+	}
+
+	// Whether the program came from the binary cache, and how long the
+	// constructor took (reading the sources included)
+	bool isFromBinaryCache() const { return fromBinaryCache; }
+	double getLoadMilliseconds() const { return loadMilliseconds; }
+
+	// Uses the current shader
+	void Use()
+	{
+		GL_STATS_COUNT(STAT_PROGRAM_BINDS);
+		glUseProgram(this->ID);
+	}
+
+	void setBool(const std::string& name, bool value) const
+	{
+		countUniform(sizeof(int));
+		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+	}
+	// ------------------------------------------------------------------------
+	void setInt(const std::string& name, int value) const
+	{
+		countUniform(sizeof(int));
+		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+	}
+	// ------------------------------------------------------------------------
+	void setFloat(const std::string& name, float value) const
+	{
+		countUniform(sizeof(float));
+		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+	}
+	// ------------------------------------------------------------------------
+	void setVec2(const std::string& name, float v1, float v2) const
+	{
+		countUniform(2 * sizeof(float));
+		glUniform2f(glGetUniformLocation(this->ID, name.c_str()), v1, v2);
+	}
+
+	void setVec3(const std::string& name, float v1, float v2, float v3) const
+	{
+		countUniform(3 * sizeof(float));
+		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+	}
+
+	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
+	{
+		countUniform(4 * sizeof(float));
+		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+	}
+
+	void setMat4(const std::string& name, float *v) const
+	{
+		countUniform(16 * sizeof(float));
+		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+	}
+
+private:
+	bool fromBinaryCache;
+	double loadMilliseconds;
+
+	// #version has to stay the first statement of the source
+	static std::string injectDefines(const std::string& code, const std::string& defines)
+	{
+		size_t version = code.find("#version");
+		if (version == std::string::npos)
+		{
+			return defines + code;
+		}
+
+		size_t lineEnd = code.find('\n', version);
+		if (lineEnd == std::string::npos)
+		{
+			return code + "\n" + defines;
+		}
+
+		return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+	}
+
+	static std::string& binaryCacheDirectory()
+	{
+		static std::string directory;
+		return directory;
+	}
+
+	void build(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		fromBinaryCache = false;
+		std::string cachePath;
+
+		if (!binaryCacheDirectory().empty() && supportsProgramBinaries())
+		{
+			unsigned long long hash = hashSources(vertexCode, fragmentCode);
+			char fileName[32];
+			snprintf(fileName, sizeof(fileName), "/%016llx.bin", hash);
+			cachePath = binaryCacheDirectory() + fileName;
+
+			if (loadBinary(cachePath, hash))
+			{
+				fromBinaryCache = true;
+				return;
+			}
+		}
+
+		compile(vertexCode, fragmentCode, !cachePath.empty());
+
+		if (!cachePath.empty())
+		{
+			saveBinary(cachePath, hashSources(vertexCode, fragmentCode));
+		}
+	}
+
+	void compile(const std::string& vertexCode, const std::string& fragmentCode, bool retrievable)
+	{
 		const GLchar* vShaderCode = vertexCode.c_str();
 		const GLchar * fShaderCode = fragmentCode.c_str();
 		// 2. Compile shaders
 		GLuint vertex, fragment;
 		GLint success;
-		GLchar infoLog[512];
 		// Vertex Shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vertex, 1, &vShaderCode, NULL);
@@ -65,8 +207,7 @@ public:
 		glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
 		if (!success)
 		{
-			glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << getShaderInfoLog(vertex) << std::endl;
 		}
 		// Fragment Shader
 		fragment = glCreateShader(GL_FRAGMENT_SHADER);
@@ -76,11 +217,15 @@ public:
 		glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
 		if (!success)
 		{
-			glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+			std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << getShaderInfoLog(fragment) << std::endl;
 		}
 		// Shader Program
 		this->ID = glCreateProgram();
+		// Ask the driver to keep the linked binary around for glGetProgramBinary
+		if (retrievable)
+		{
+			glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 		glAttachShader(this->ID, vertex);
 		glAttachShader(this->ID, fragment);
 		glLinkProgram(this->ID);
@@ -88,48 +233,140 @@ public:
 		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
 		if (!success)
 		{
-			glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << getProgramInfoLog(this->ID) << std::endl;
 		}
 		// Delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
+	}
+
+	// Loads the program from the cache file. The driver may reject a binary
+	// (other GPU, driver update): then the file is ignored and rewritten
+	bool loadBinary(const std::string& path, unsigned long long hash)
+	{
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
 
+		unsigned long long fileHash = 0;
+		GLenum format = 0;
+		GLint length = 0;
+		file.read((char*)&fileHash, sizeof(fileHash));
+		file.read((char*)&format, sizeof(format));
+		file.read((char*)&length, sizeof(length));
+
+		if (!file || fileHash != hash || length <= 0)
+		{
+			return false;
+		}
+
+		std::vector<char> binary(length);
+		if (!file.read(binary.data(), length))
+		{
+			return false;
+		}
+
+		this->ID = glCreateProgram();
+		glProgramBinary(this->ID, format, binary.data(), length);
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glDeleteProgram(this->ID);
+			this->ID = 0;
+			return false;
+		}
+
+		return true;
 	}
-	// Uses the current shader
-	void Use()
+
+	void saveBinary(const std::string& path, unsigned long long hash) const
 	{
-		glUseProgram(this->ID);
+		GLint success = GL_FALSE, length = 0;
+		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+		glGetProgramiv(this->ID, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (!success || length <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(this->ID, length, &length, &format, binary.data());
+
+		std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+		file.write((const char*)&hash, sizeof(hash));
+		file.write((const char*)&format, sizeof(format));
+		file.write((const char*)&length, sizeof(length));
+		file.write(binary.data(), length);
+
+		if (!file)
+		{
+			std::cout << "ERROR::SHADER::BINARY_CACHE_NOT_WRITTEN " << path << std::endl;
+		}
 	}
 
-	void setBool(const std::string& name, bool value) const
+	static bool supportsProgramBinaries()
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
 	}
-	// ------------------------------------------------------------------------
-	void setInt(const std::string& name, int value) const
+
+	// FNV-1a (64 bits) of both sources and of the strings that identify the driver
+	static unsigned long long hashSources(const std::string& vertexCode, const std::string& fragmentCode)
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		const GLubyte* driverStrings[3] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+		unsigned long long hash = 14695981039346656037ULL;
+
+		hash = hashString(hash, vertexCode.c_str(), vertexCode.size());
+		hash = hashString(hash, fragmentCode.c_str(), fragmentCode.size());
+		for (int i = 0; i < 3; i++)
+		{
+			const char* text = driverStrings[i] ? (const char*)driverStrings[i] : "";
+			hash = hashString(hash, text, strlen(text));
+		}
+
+		return hash;
 	}
-	// ------------------------------------------------------------------------
-	void setFloat(const std::string& name, float value) const
+
+	static unsigned long long hashString(unsigned long long hash, const char* text, size_t length)
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		for (size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+		}
+		// Separator, so that moving text from one source to the next changes the hash
+		return (hash ^ 0xff) * 1099511628211ULL;
 	}
-	// ------------------------------------------------------------------------
-	void setVec3(const std::string& name, float v1, float v2, float v3) const
+
+	// The info logs are read with the length reported by the driver, never truncated
+	static std::string getShaderInfoLog(GLuint shader)
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		GLint length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> infoLog(length > 0 ? length : 1, '\0');
+		glGetShaderInfoLog(shader, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		return std::string(infoLog.data());
 	}
 
-	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
+	static std::string getProgramInfoLog(GLuint program)
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> infoLog(length > 0 ? length : 1, '\0');
+		glGetProgramInfoLog(program, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		return std::string(infoLog.data());
 	}
 
-	void setMat4(const std::string& name, float *v) const
+	// Counts one uniform upload for the GL statistics (no-op in release builds)
+	static void countUniform(unsigned long bytes)
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		GL_STATS_COUNT(STAT_UNIFORM_UPLOADS);
+		GL_STATS_ADD(STAT_UNIFORM_BYTES, bytes);
 	}
 };
 
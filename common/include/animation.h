@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace std;
+
+struct AnimationKeyframe
+{
+	float time;
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+};
+
+// Layout do arquivo binário .anim (little-endian, todos os campos com 4 bytes
+// para que o arquivo possa ser mapeado em memória e usado sem conversão):
+//
+//   AnimationFileHeader
+//   AnimationTrackInfo tracks[trackCount]
+//   float times[keyCount]
+//   float positions[keyCount * 3]
+//   float rotations[keyCount * 4]  (x, y, z, w)
+//   float scales[keyCount * 3]
+//
+// As chaves de todas as trilhas ficam em sequência (SoA), cada trilha guarda
+// apenas o índice da sua primeira chave e quantas chaves possui. load() recusa
+// arquivos com trilhas fora das chaves ou com tempos fora de ordem.
+struct AnimationFileHeader
+{
+	char magic[4]; // "ANIM"
+	uint32_t version;
+	uint32_t trackCount;
+	uint32_t keyCount;
+	float duration;
+};
+
+struct AnimationTrackInfo
+{
+	uint32_t firstKey;
+	uint32_t keyCount;
+};
+
+class AnimationClip
+{
+public:
+	AnimationClip();
+	~AnimationClip();
+	//Acrescenta uma trilha copiando o clip inteiro: para edições pequenas. Clips com
+	//muitas trilhas devem ser montados de uma vez com build()
+	int addTrack(const vector <AnimationKeyframe>& keyframes);
+	//Substitui o clip por estas trilhas, alocando os dados uma única vez
+	void build(const vector <vector <AnimationKeyframe> >& trackKeyframes);
+	bool save(const string& path) const;
+	bool load(const string& path);
+	int getNbTracks() const { return header ? header->trackCount : 0; }
+	float getDuration() const { return header ? header->duration : 0.0f; }
+	const AnimationTrackInfo* getTracks() const { return tracks; }
+	const float* getTimes() const { return times; }
+	const glm::vec3* getPositions() const { return (const glm::vec3*)positions; }
+	const glm::quat* getRotations() const { return (const glm::quat*)rotations; }
+	const glm::vec3* getScales() const { return (const glm::vec3*)scales; }
+protected:
+	AnimationClip(const AnimationClip&);
+	AnimationClip& operator=(const AnimationClip&);
+	void bindSections(const char* data);
+	void unload();
+	//Dados do arquivo: ou mapeados em memória (mapped) ou copiados para ownedData
+	vector <char> ownedData;
+	void* mapped;
+	size_t mappedSize;
+	const AnimationFileHeader* header;
+	const AnimationTrackInfo* tracks;
+	const float* times;
+	const float* positions;
+	const float* rotations;
+	const float* scales;
+};
+
+// Avalia todas as trilhas de um clip para um instante de tempo em uma única
+// passada pelos arrays contíguos. Guarda a última chave usada por trilha para
+// que, com o tempo avançando, a busca pela chave seja O(1) amortizado.
+class AnimationSampler
+{
+public:
+	AnimationSampler() : clip(NULL), looping(true) {}
+	void initialize(const AnimationClip* clip, bool looping = true);
+	void sample(float time, glm::vec3* positions, glm::quat* rotations, glm::vec3* scales);
+protected:
+	const AnimationClip* clip;
+	bool looping;
+	vector <uint32_t> cursors;
+};
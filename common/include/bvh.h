@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Nó da BVH: 32 bytes, dois por linha de cache. Os dois filhos de um nó interno
+// ficam lado a lado no vetor de nós, sempre depois do pai
+struct BvhNode
+{
+	glm::vec3 min;
+	int leftFirst; //Nó interno: índice do filho esquerdo (o direito é o seguinte); folha: primeiro item
+	glm::vec3 max;
+	int count; //Itens da folha; 0 nos nós internos
+};
+
+// Hierarquia de caixas (AABB) sobre itens com índices de 0 a count - 1, para
+// consultas em O(log n) em vez de testar todos os itens.
+//
+// A construção é top-down pela heurística de área (SAH): em cada nó os centros
+// dos itens são distribuídos em BIN_COUNT intervalos em cada eixo, e o corte
+// escolhido é o que minimiza o custo esperado de uma consulta (área de cada
+// lado vezes o número de itens). Um nó vira folha quando nenhum corte é mais
+// barato que testar os seus itens. Os nós ficam em um único vetor, e as caixas
+// dos itens são copiadas na ordem das folhas, então as consultas leem a memória
+// em sequência.
+//
+// Quando os itens se movem, refit recalcula as caixas sem mudar a árvore (de
+// baixo para cima, em O(n)). A árvore continua correta, mas fica pior a cada
+// movimento grande; aí vale chamar build de novo.
+//
+//   bvh.build(mins, maxs, count);
+//   bvh.refit(mins, maxs);                       //Depois de mover os itens
+//   bvh.queryFrustum(camera.getFrustumPlanes(), visible);
+class Bvh
+{
+public:
+	static const int BIN_COUNT = 16;
+	//Folhas com mais itens que isso são divididas mesmo que o SAH prefira não dividir
+	static const int MAX_LEAF_SIZE = 8;
+	//Limite da profundidade (as consultas usam pilhas fixas); nós mais fundos viram folhas
+	static const int MAX_DEPTH = 64;
+
+	//Distância ao item ao longo do raio, ou um valor negativo se o raio não acerta o
+	//item antes de maxDistance. Sem função, a distância é a da caixa do item
+	typedef std::function<float(int item, float maxDistance)> RayFunction;
+
+	Bvh() : depth(0) {}
+	void build(const glm::vec3* mins, const glm::vec3* maxs, int count);
+	//Mesmos itens do build, com as caixas novas
+	void refit(const glm::vec3* mins, const glm::vec3* maxs);
+
+	//Os itens encontrados são adicionados ao fim de items
+	void queryFrustum(const glm::vec4* planes, vector <int>& items) const;
+	void queryBox(const glm::vec3& min, const glm::vec3& max, vector <int>& items) const;
+	void querySphere(const glm::vec3& center, float radius, vector <int>& items) const;
+	//Item mais próximo acertado pelo raio (direção normalizada), ou -1. Os nós são
+	//visitados do mais próximo para o mais distante, e os que começam depois do
+	//acerto mais próximo até agora são pulados
+	int raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance, const RayFunction& intersect = RayFunction()) const;
+
+	int getNodeCount() const { return (int)nodes.size(); }
+	int getItemCount() const { return (int)itemIds.size(); }
+	int getDepth() const { return depth; }
+	const vector <BvhNode>& getNodes() const { return nodes; }
+	//Índices dos itens na ordem das folhas: uma folha tem os itens [leftFirst, leftFirst + count)
+	const vector <int>& getItemIds() const { return itemIds; }
+	//Custo SAH da árvore (travessias + testes de itens esperados por consulta)
+	float getSahCost() const;
+
+	//1 / direction, com os componentes zerados trocados por um valor grande e finito
+	static glm::vec3 getInverseDirection(const glm::vec3& direction);
+	//Distância de entrada do raio na caixa, ou -1 se não acerta antes de maxDistance
+	static float intersectBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+	//Mesmo retorno, para uma esfera e um raio com direção normalizada
+	static float intersectSphere(const glm::vec3& center, float radius, const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+protected:
+	void subdivide(int node, int level);
+	void updateBounds(int node);
+	void addSubtree(int node, vector <int>& items) const;
+
+	vector <BvhNode> nodes;
+	vector <int> itemIds; //Índices dos itens na ordem das folhas
+	vector <glm::vec3> itemMins, itemMaxs; //Caixas na ordem das folhas
+	int depth;
+};
@@ -7,7 +7,24 @@
 
 #include "Shader.h"
 
+//Ordem dos planos do frustum em getFrustumPlanes()
+enum FrustumPlane
+{
+	FRUSTUM_LEFT,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANE_COUNT
+};
 
+// As matrizes view, projection e viewProjection e os planos do frustum ficam
+// guardados na câmera e só são recalculados quando a posição, a orientação
+// ou a projeção mudam. getRevision() é incrementado a cada mudança, para que
+// quem usa as matrizes saiba quando atualizar. Com um shader as matrizes são
+// enviadas direto para ele; com nullptr elas devem ser publicadas por um
+// ViewUniforms, que qualquer número de programas pode ler.
 class Camera
 {
 public:
@@ -16,12 +33,52 @@ public:
 	void initialize(Shader* shader, int width, int height, float sensitivity = 0.05, float pitch = 0.0, float yaw = -90.0, glm::vec3 cameraFront = glm::vec3(0.0, 0.0, -1.0), glm::vec3 cameraPos = glm::vec3(0.0, 0.0, 3.0), glm::vec3 cameraUp = glm::vec3(0.0, 1.0, 0.0));
 	void move(GLFWwindow* window, int key, int action);
 	void rotate(GLFWwindow* window, double xpos, double ypos);
-	void update();
+	void pollKeys(GLFWwindow* window);
+	void update(float deltaTime);
+	void resize(int width, int height);
+	void setPerspective(float fovy, float nearPlane, float farPlane);
+	void setReverseZ(bool reverseZ);
+	bool isReverseZ() const { return reverseZ; }
+	const glm::mat4& getViewMatrix() const { return view; }
+	const glm::mat4& getProjectionMatrix() const { return projection; }
+	const glm::mat4& getViewProjectionMatrix() const { return viewProjection; }
+	const glm::vec4* getFrustumPlanes() const { return frustumPlanes; }
+	const glm::vec3& getPosition() const { return cameraPos; }
+	float getFovy() const { return fovy; }
+	float getAspectRatio() const { return aspectRatio; }
+	float getNearPlane() const { return nearPlane; }
+	float getFarPlane() const { return farPlane; }
+	unsigned int getRevision() const { return revision; }
+	bool isSphereVisible(const glm::vec3& center, float radius) const { return isSphereInFrustum(frustumPlanes, center, radius); }
+	static bool isSphereInFrustum(const glm::vec4* planes, const glm::vec3& center, float radius);
+	bool isBoxVisible(const glm::vec3& min, const glm::vec3& max) const;
+	//Diâmetro aproximado da esfera na tela, em pixels, para uma view com essa altura
+	float getProjectedDiameter(const glm::vec3& center, float radius, float viewportHeight) const;
+	//Raio que sai da câmera e passa pelo pixel (x, y) de uma view width x height (y para baixo, como o mouse)
+	void getRay(float x, float y, float width, float height, glm::vec3& origin, glm::vec3& direction) const;
 
 protected:
+	void updateMatrices();
 	Shader* shader;
 	bool firstMouse;
 	float lastX, lastY, pitch, yaw;
 	float sensitivity;
+	float movementSpeed; //Velocidade máxima, em unidades por segundo
+	float acceleration; //Unidades por segundo ao quadrado
+	float damping; //Taxa do amortecimento exponencial, em 1/s
+	glm::vec3 velocity;
+	float mouseDeltaX, mouseDeltaY; //Deslocamento do mouse acumulado desde o último update
+	bool moveForward, moveBackward, moveLeft, moveRight;
 	glm::vec3 cameraFront, cameraPos, cameraUp;
+	float aspectRatio;
+	float fovy; //Em graus
+	float nearPlane, farPlane;
+	//Projeção reverse-Z com far no infinito: profundidade 1 no near e 0 no infinito
+	bool reverseZ;
+
+	//Estado em cache e o que precisa ser recalculado no próximo update
+	bool orientationDirty, viewDirty, projectionDirty;
+	unsigned int revision;
+	glm::mat4 view, projection, viewProjection;
+	glm::vec4 frustumPlanes[FRUSTUM_PLANE_COUNT];
 };
@@ -6,5 +6,4 @@ class Bezier :
 {
 public:
     Bezier();
-    void generateCurve(int pointsPerSegment);
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+
+#include "Shader.h"
+#include "curve.h"
+
+using namespace std;
+
+// Conjunto de curvas com o mesmo número de pontos de controle desenhadas
+// inteiramente na GPU: apenas os pontos de controle são enviados (em um
+// texture buffer) e o vertex shader avalia a curva a partir de gl_VertexID
+// (ponto na curva) e gl_InstanceID (qual curva), usando a matriz de base.
+// Editar um ponto de controle custa um glBufferSubData de 12 bytes.
+class CurveBatch
+{
+public:
+	CurveBatch() : nCurves(0), maxCurves(0), VAO(0), TBO(0), texture(0), shader(NULL) {}
+	void initialize(Shader* shader, const Curve& curveType, int nControlPointsPerCurve, int pointsPerSegment, int maxCurves);
+	int addCurve(const vector <glm::vec3>& controlPoints);
+	void setControlPoint(int curve, int i, glm::vec3 point);
+	void drawCurves(glm::vec4 color);
+	void release();
+	int getNbCurves() const { return nCurves; }
+	int getNbVerticesPerCurve() const { return nSegments * pointsPerSegment + 1; }
+protected:
+	int nControlPointsPerCurve;
+	int nSegments;
+	int pointsPerSegment;
+	int nCurves;
+	int maxCurves;
+	int segmentStride;
+	glm::mat4 M; //Matriz de base
+	GLuint VAO; //VAO vazio, os vértices são gerados no vertex shader
+	GLuint TBO; //Buffer com os pontos de controle de todas as curvas
+	GLuint texture; //Textura (GL_TEXTURE_BUFFER) que expõe o TBO ao shader
+	Shader* shader;
+};
@@ -15,17 +15,26 @@ using namespace std;
 class Curve
 {
 public:
-	Curve() {}
-	inline void setControlPoints(vector <glm::vec3> controlPoints) { this->controlPoints = controlPoints; }
+	Curve() : segmentStride(1), pointsPerSegment(0), VAO(0), VBO(0) {}
+	inline void setControlPoints(const vector <glm::vec3>& controlPoints) { this->controlPoints = controlPoints; }
 	void setShader(Shader* shader);
 	void generateCurve(int pointsPerSegment);
+	void setControlPoint(int i, glm::vec3 point);
 	void drawCurve(glm::vec4 color);
+	void release();
 	int getNbCurvePoints() { return curvePoints.size(); }
 	glm::vec3 getPointOnCurve(int i) { return curvePoints[i]; }
+	glm::vec3 evaluate(float u) const;
+	const glm::mat4& getBasisMatrix() const { return M; }
+	int getSegmentStride() const { return segmentStride; }
 protected:
+	int getNbSegments() const { return controlPoints.size() < 4 ? 0 : (controlPoints.size() - 4) / segmentStride + 1; }
+	void evaluateSegment(int segment);
 	vector <glm::vec3> controlPoints;
 	vector <glm::vec3> curvePoints;
 	glm::mat4 M; //Matriz de base
-	GLuint VAO;
+	int segmentStride; //Quantos pontos de controle avançar entre um segmento e o próximo
+	int pointsPerSegment;
+	GLuint VAO, VBO;
 	Shader* shader;
-};
+};
\ No newline at end of file
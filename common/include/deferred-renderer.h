@@ -0,0 +1,80 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Shader.h"
+#include "camera.h"
+#include "gl-stats.h"
+
+// Caminho deferred: a geometria só grava as entradas da iluminação em um
+// G-buffer e as luzes são somadas depois, uma vez por pixel visível, em vez de
+// uma vez por fragmento desenhado.
+//
+//   1. G-buffer: a cena é desenhada com as variantes DEFERRED dos shaders
+//      gAlbedo    RGBA8    cor base, 1 se tem iluminação
+//      gNormal    RGBA16F  normal, expoente especular
+//      gAmbient   RGBA16F  ka
+//      gDiffuse   RGBA16F  kd
+//      gSpecular  RGBA16F  ks
+//      depth      DEPTH32F a posição é reconstruída com a inversa da viewProjection
+//   Os coeficientes ficam em float com os três canais, então materiais coloridos
+//   e valores acima de 1 têm o mesmo resultado do forward
+//   2. Luzes: um triângulo de tela inteira soma ambiente, luz principal e as
+//      luzes pontuais dos froxels do LightClusters ligado (tiles na tela e
+//      fatias na profundidade) em um alvo RGBA16F. O alvo tem uma cópia da
+//      profundidade do G-buffer e o triângulo fica na profundidade do fundo,
+//      então os pixels sem geometria são descartados antes do fragment shader
+//   3. Composição: copia as luzes somadas e a profundidade para o framebuffer
+//      de saída, mantendo o fundo
+//
+//   deferred.beginGeometry();                     //Liga o G-buffer
+//   ...draws com as variantes DEFERRED...
+//   clusters.bind();                              //Só com as luzes pontuais
+//   deferred.accumulateLights(camera, viewport);
+//   deferred.composite();                         //Volta para o framebuffer de saída
+class DeferredRenderer
+{
+public:
+	//Unidades de textura do G-buffer (0 a 3 são a textura difusa e o LightClusters)
+	static const int ALBEDO_UNIT = 4;
+	static const int NORMAL_UNIT = 5;
+	static const int AMBIENT_UNIT = 6;
+	static const int DIFFUSE_UNIT = 7;
+	static const int SPECULAR_UNIT = 8;
+	static const int DEPTH_UNIT = 9;
+	static const int LIGHTING_UNIT = 10;
+	//Texturas de cor do G-buffer (saídas 0 a 4 dos shaders DEFERRED)
+	static const int GBUFFER_COLORS = 5;
+
+	DeferredRenderer() : width(0), height(0), zeroToOneDepth(false), clearDepth(1.0f), outputFBO(0), gBufferFBO(0), lightingShader(NULL), compositeShader(NULL) {}
+	//lightingShader: fullscreen.vert/deferred-lighting.frag (com CLUSTERED para as luzes pontuais);
+	//compositeShader: fullscreen.vert/deferred-composite.frag
+	void initialize(int width, int height, Shader* lightingShader, Shader* compositeShader);
+	//Com glClipControl(GL_ZERO_TO_ONE) a profundidade já é o z em NDC
+	void setZeroToOneDepth(bool zeroToOne) { zeroToOneDepth = zeroToOne; }
+	void beginGeometry();
+	//viewport: área da tela desenhada com esta câmera, em pixels
+	void accumulateLights(const Camera& camera, glm::vec4 viewport);
+	void composite();
+	void release();
+
+protected:
+	void drawFullscreen(Shader& shader, float depth) const;
+	//As primeiras `count` texturas do G-buffer, nas suas unidades
+	void bindTextures(int count) const;
+
+	int width, height;
+	bool zeroToOneDepth;
+	float clearDepth; //Profundidade dos pixels sem geometria
+	GLint outputFBO; //Framebuffer ligado antes do G-buffer, onde a composição escreve
+
+	GLuint gBufferFBO;
+	GLuint textures[8]; //Albedo, normal, ka, kd, ks, profundidade, luzes somadas e a cópia da profundidade
+	GLuint lightingFBO;
+	GLuint emptyVAO; //Os triângulos de tela inteira vêm de gl_VertexID
+
+	Shader* lightingShader;
+	Shader* compositeShader;
+};
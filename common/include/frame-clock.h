@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+
+// Relógio central da aplicação. Mede o tempo entre frames para que as
+// animações dependam do tempo e não da taxa de quadros. Pode ser pausado,
+// acelerado/desacelerado (timeScale) e também oferece um acumulador para
+// simulações com passo fixo:
+//
+//   clock.tick();
+//   while (clock.stepFixed())
+//       simulate(clock.getFixedStep());
+//
+// Com setFixedDelta(d) cada tick avança exatamente d segundos, o que torna
+// capturas e replays determinísticos independente da máquina.
+class FrameClock
+{
+public:
+	FrameClock();
+	void initialize(float fixedStep = 1.0f / 60.0f, float maxDelta = 0.25f);
+	void tick();
+	void tick(float realDelta);
+	bool stepFixed();
+	void setPaused(bool paused) { this->paused = paused; }
+	bool isPaused() const { return paused; }
+	void setTimeScale(float timeScale) { this->timeScale = timeScale; }
+	float getTimeScale() const { return timeScale; }
+	void setFixedDelta(float fixedDelta) { this->fixedDelta = fixedDelta; }
+	float getDeltaTime() const { return deltaTime; }
+	float getRealDeltaTime() const { return realDeltaTime; }
+	float getFixedStep() const { return fixedStep; }
+	float getAlpha() const { return accumulator / fixedStep; }
+	double getTime() const { return time; }
+	unsigned long getFrameIndex() const { return frameIndex; }
+protected:
+	std::chrono::steady_clock::time_point lastTick;
+	bool started;
+	bool paused;
+	float timeScale;
+	float fixedDelta; //Se maior que zero, substitui o tempo medido
+	float fixedStep;
+	float maxDelta; //Limita o delta após travamentos (breakpoints, janela arrastada...)
+	float deltaTime; //Delta já escalado, zero quando pausado
+	float realDeltaTime;
+	float accumulator;
+	double time;
+	unsigned long frameIndex;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Contadores de chamadas OpenGL por frame (draw calls, uploads de uniforms,
+// binds de textura, mudanças de estado...). Só existem em builds de debug:
+// com NDEBUG definido as macros GL_STATS_* viram nada e nenhuma instrução
+// é gerada nos pontos instrumentados. Para forçar, defina GL_STATS_ENABLED.
+#ifndef GL_STATS_ENABLED
+#ifdef NDEBUG
+#define GL_STATS_ENABLED 0
+#else
+#define GL_STATS_ENABLED 1
+#endif
+#endif
+
+enum GLStat
+{
+	STAT_DRAW_CALLS,
+	STAT_VERTICES,
+	STAT_UNIFORM_UPLOADS,
+	STAT_UNIFORM_BYTES,
+	STAT_TEXTURE_BINDS,
+	STAT_VERTEX_ARRAY_BINDS,
+	STAT_BUFFER_UPLOADS,
+	STAT_BUFFER_BYTES,
+	STAT_PROGRAM_BINDS,
+	STAT_STATE_CHANGES, //Trocas de estado entre draws da RenderQueue
+	STAT_STATE_CHANGES_AVOIDED, //Trocas a menos que na ordem em que os draws foram enviados
+	STAT_COUNT
+};
+
+class GLStats
+{
+public:
+	static const int DEFAULT_WINDOW = 120;
+
+	GLStats() : windowSize(DEFAULT_WINDOW), framesRecorded(0), nextFrame(0)
+	{
+		for (int i = 0; i < STAT_COUNT; i++)
+		{
+			current[i] = 0;
+		}
+	}
+
+	//Instância única, compartilhada pelo Shader.h (header-only) e pelas classes do common
+	static GLStats& instance()
+	{
+		static GLStats stats;
+		return stats;
+	}
+
+	void add(GLStat stat, unsigned long amount = 1) { current[stat] += amount; }
+	unsigned long getCurrent(GLStat stat) const { return current[stat]; }
+
+	void setWindowSize(int frames);
+	void endFrame();
+	unsigned long getMin(GLStat stat) const;
+	unsigned long getMax(GLStat stat) const;
+	double getAverage(GLStat stat) const;
+	string getSummary() const;
+	static const char* getName(GLStat stat);
+
+protected:
+	unsigned long current[STAT_COUNT];
+	//Janela circular com os contadores dos últimos windowSize frames
+	vector <unsigned long> history;
+	int windowSize;
+	int framesRecorded;
+	int nextFrame;
+};
+
+#if GL_STATS_ENABLED
+#define GL_STATS_ADD(stat, amount) GLStats::instance().add(stat, amount)
+#define GL_STATS_END_FRAME() GLStats::instance().endFrame()
+#else
+#define GL_STATS_ADD(stat, amount) ((void)0)
+#define GL_STATS_END_FRAME() ((void)0)
+#endif
+
+#define GL_STATS_COUNT(stat) GL_STATS_ADD(stat, 1)
@@ -0,0 +1,39 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "gl-stats.h"
+
+// Buffer de matrizes model por instância, lidas pelo vertex shader como um
+// atributo mat4 (locations 4 a 7, com divisor 1):
+//
+//   layout (location = 4) in mat4 model;
+//
+// São dois buffers alternados: enquanto um está mapeado e sendo escrito (por
+// qualquer thread), o outro, escrito no frame anterior, é usado nos draws.
+//
+//   glm::mat4* models = instances.map();   //Thread da OpenGL
+//   ...escreve models[0..n)...             //Qualquer thread
+//   instances.unmap();                     //Thread da OpenGL, antes dos draws
+//   instances.attach(VAO, firstInstance);
+class InstanceBuffer
+{
+public:
+	static const GLuint MODEL_LOCATION = 4;
+
+	InstanceBuffer() : maxInstances(0), writeSlot(0), drawSlot(0), mapped(NULL) {}
+	void initialize(int maxInstances);
+	glm::mat4* map();
+	void unmap();
+	void attach(GLuint VAO, int firstInstance) const;
+	void release();
+
+protected:
+	GLuint buffers[2];
+	int maxInstances;
+	int writeSlot;
+	int drawSlot;
+	glm::mat4* mapped;
+};
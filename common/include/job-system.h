@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef std::function<void()> JobFunction;
+
+class JobCounter;
+
+struct Job
+{
+	JobFunction function;
+	JobCounter* counter; //Decrementado quando o job termina (pode ser NULL)
+};
+
+// Contador de dependência: cada job lançado com ele incrementa o contador e
+// o decrementa ao terminar. Jobs lançados com ele como dependência só entram
+// na fila quando o contador chega a zero.
+class JobCounter
+{
+public:
+	JobCounter() : count(0) {}
+	bool isDone() const { return count.load() == 0; }
+protected:
+	friend class JobSystem;
+	std::atomic<int> count;
+	std::mutex mutex;
+	vector <Job> continuations;
+};
+
+// Sistema de jobs com roubo de trabalho: cada thread tem a sua fila (deque),
+// onde empilha e desempilha pelo fim; uma thread sem trabalho rouba do início
+// da fila de outra. A thread que chama initialize() é a thread 0 e participa
+// da execução enquanto espera em wait() ou parallelFor().
+class JobSystem
+{
+public:
+	JobSystem() : running(false), queuedJobs(0) {}
+	~JobSystem() { shutdown(); }
+	void initialize(int workerCount = -1);
+	void shutdown();
+	void run(const JobFunction& function, JobCounter* counter = NULL, JobCounter* dependency = NULL);
+	void wait(JobCounter* counter);
+	void parallelFor(int count, int grainSize, const std::function<void(int, int)>& function);
+	int getThreadCount() const { return (int)queues.size(); }
+protected:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque <Job> jobs;
+	};
+	void push(const Job& job);
+	bool pop(Job& job);
+	void execute(Job& job);
+	void workerLoop(int index);
+	vector <WorkQueue*> queues;
+	vector <std::thread> workers;
+	std::atomic<bool> running;
+	std::atomic<int> queuedJobs;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+};
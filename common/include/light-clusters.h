@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "camera.h"
+#include "gl-stats.h"
+
+using namespace std;
+
+// Luz pontual com alcance limitado: não ilumina nada a mais de `radius` do centro
+struct PointLight
+{
+	glm::vec3 position; //Em coordenadas de mundo
+	float radius;
+	glm::vec3 color;
+};
+
+// Conteúdo do uniform block "Clusters" (layout std140, mesma ordem dos shaders)
+struct ClusterBlock
+{
+	glm::vec4 grid; //Tiles em x e y, fatias em z, número de luzes
+	glm::vec4 depth; //Escala e bias da fatia (log da profundidade), near e far
+	glm::vec4 viewport; //Origem da view na tela e tamanho de um tile, em pixels
+};
+
+// Iluminação "clustered forward": o frustum da câmera é dividido em froxels
+// (TILES_X x TILES_Y tiles na tela e SLICES fatias exponenciais na
+// profundidade) e cada luz é associada, na CPU, aos froxels que a sua esfera
+// toca. O fragment shader descobre o seu froxel pela posição na tela e pela
+// profundidade e percorre só as luzes dele.
+//
+// Os dados vão para a GPU em texture buffers (o GLSL 4.10 não tem SSBOs):
+//   clusterLights   RGBA32F  2 texels por luz: posição + raio, cor
+//   clusterRanges   RG32UI   1 texel por froxel: início e quantidade na lista
+//   clusterIndices  R32UI    lista de índices de luzes, agrupada por froxel
+//
+// build() não usa a OpenGL e pode rodar em qualquer thread; upload() e bind()
+// rodam na thread da OpenGL. Com várias views, cada uma usa o seu LightClusters.
+class LightClusters
+{
+public:
+	static const int TILES_X = 16;
+	static const int TILES_Y = 16;
+	static const int SLICES = 24;
+	static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+	//Ponto de ligação do block "Clusters" (o block "View" usa o 0)
+	static const GLuint BINDING = 1;
+	//Unidades de textura dos texture buffers (a 0 é a textura difusa)
+	static const int LIGHTS_UNIT = 1;
+	static const int RANGES_UNIT = 2;
+	static const int INDICES_UNIT = 3;
+
+	LightClusters() : UBO(0), lightCount(0), maxClusterLights(0), fovy(0.0f), aspectRatio(0.0f), nearPlane(0.0f), farPlane(0.0f), infiniteFar(false) {}
+	void initialize();
+	void attach(Shader& shader) const;
+	//Associa as luzes aos froxels da câmera; com useSimd = false usa o teste escalar
+	void build(const Camera& camera, const vector <PointLight>& lights, bool useSimd = true);
+	//viewport: área da tela desenhada com esta câmera, em pixels
+	void upload(glm::vec4 viewport);
+	void bind() const;
+	void release();
+
+	int getLightCount() const { return lightCount; }
+	int getMaxClusterLights() const { return maxClusterLights; }
+	int getIndexCount() const { return (int)indices.size(); }
+
+protected:
+	void updateBounds(const Camera& camera);
+	void binLight(int light, const glm::vec3& center, float radius, bool useSimd);
+
+	GLuint UBO;
+	GLuint buffers[3]; //Luzes, intervalos e índices
+	GLuint textures[3];
+
+	//Caixas (AABB) de cada froxel no espaço da view, em arrays separados para o teste SIMD.
+	//z é a profundidade (positiva), e os froxels de uma fatia são contíguos
+	vector <float> minX, minY, minZ, maxX, maxY, maxZ;
+	float sliceScale, sliceBias;
+
+	//Resultado de build()
+	vector <glm::vec4> lightData;
+	vector <unsigned int> pairClusters, pairLights; //Pares (froxel, luz) antes da ordenação
+	vector <unsigned int> ranges; //Início e quantidade de cada froxel
+	vector <unsigned int> indices;
+	int lightCount;
+	int maxClusterLights;
+
+	//Projeção para a qual as caixas foram calculadas. Com reverse-Z a projeção não tem
+	//plano far: as fatias ainda vão até farPlane, mas a última se estende até o infinito
+	float fovy, aspectRatio, nearPlane, farPlane;
+	bool infiniteFar;
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 struct Material
 {
   std::string name;
@@ -7,4 +9,5 @@ struct Material
   string texturePath;
   float shininess;
   int textureId;
+  int illumination; // Modelo de iluminação do MTL (illum): 0 sem luz, 1 ambiente + difusa, 2 com especular
 };
\ No newline at end of file
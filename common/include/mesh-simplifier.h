@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Simplificação de malhas por colapso de arestas, ordenado pela métrica de
+// erro quádrica (Garland & Heckbert): cada posição acumula as quádricas dos
+// planos dos seus triângulos, e colapsar a aresta a -> b custa a soma das
+// distâncias ao quadrado de b a esses planos.
+//
+// A entrada são vértices não indexados no layout do parseOBJFile (11 floats:
+// posição, cor, textura e normal). Os vértices iguais são unidos, e as
+// posições com mais de um conjunto de atributos (costuras de UV ou de
+// normais) ou em bordas abertas ficam travadas: elas nunca são removidas,
+// então as costuras continuam no mesmo lugar e com as mesmas coordenadas dos
+// dois lados. Os colapsos são de meia aresta (a posição que fica é uma das
+// originais), então nenhum atributo precisa ser interpolado.
+//
+//   MeshSimplifier simplifier;
+//   simplifier.initialize(parsedObj.vertices);
+//   simplifier.simplify(simplifier.getTriangleCount() / 2);  //Continua da chamada anterior
+//   vector<float> lod1 = simplifier.getVertices();
+class MeshSimplifier
+{
+public:
+	static const int VERTEX_FLOATS = 11;
+
+	MeshSimplifier() : liveTriangles(0), maxError(0.0f) {}
+	void initialize(const vector <float>& vertices);
+	//Colapsa arestas até restarem no máximo targetTriangles, se possível sem passar
+	//pelas posições travadas. Retorna o número de triângulos que restaram
+	int simplify(int targetTriangles);
+	//Triângulos atuais, não indexados, no mesmo layout da entrada
+	vector <float> getVertices() const;
+
+	int getTriangleCount() const { return liveTriangles; }
+	int getLockedCount() const;
+	//Raiz do maior custo de colapso aplicado: distância aproximada da malha original
+	float getMaxError() const { return maxError; }
+
+protected:
+	//Quádrica simétrica 4x4 (só os 10 coeficientes distintos)
+	struct Quadric
+	{
+		double a[10];
+	};
+
+	struct Collapse
+	{
+		int from, to;
+		double cost;
+	};
+
+	static void addPlane(Quadric& quadric, const glm::dvec3& normal, double distance);
+	static void addQuadric(Quadric& target, const Quadric& source);
+	static double evaluate(const Quadric& quadric, const glm::dvec3& point);
+
+	void buildAdjacency();
+	bool isValidCollapse(int from, int to, int& toWedge) const;
+	void applyCollapse(int from, int to, int toWedge);
+
+	vector <float> attributes; //VERTEX_FLOATS por vértice único (wedge)
+	vector <int> wedgePosition; //Posição de cada wedge
+	vector <glm::dvec3> positions;
+	vector <int> positionWedge; //Wedge das posições não travadas (têm só um)
+	vector <char> locked;
+	vector <Quadric> quadrics;
+
+	vector <unsigned int> triangles; //3 wedges por triângulo
+	vector <char> alive;
+	int liveTriangles;
+	float maxError;
+
+	//Triângulos de cada posição (CSR), refeitos a cada passada
+	vector <int> adjacencyOffsets;
+	vector <int> adjacency;
+};
@@ -5,29 +5,72 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <vector>
+
 #include "Shader.h"
 #include "material.h"
 
+// Um nível de detalhe da malha: usado quando o objeto ocupa menos de
+// maxScreenSize pixels (diâmetro) na tela
+struct MeshLod
+{
+	GLuint VAO;
+	int nVertices;
+	float maxScreenSize;
+};
+
 class Mesh
 {
 public:
+	//Views que escolhem o nível de detalhe de forma independente (cada uma tem a sua histerese)
+	static const int MAX_LOD_VIEWS = 4;
+
 	Mesh() {}
 	~Mesh() {}
 	void initialize(GLuint VAO, int nVertices, Shader* shader, GLuint textureID,  glm::vec3 position = glm::vec3(0.0, 0.0, 0.0), glm::vec3 scale = glm::vec3(0.5, 0.5, 0.5), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
-	void update();
+	void update(float deltaTime);
 	void draw(Material material);
+	void draw(Material material, const glm::mat4& model);
+	void drawInstances(Material material, int instanceCount);
+	//Partes do drawInstances, para quem liga só o estado que mudou entre dois draws (RenderQueue).
+	//drawBoundInstances usa o VAO, a textura e o programa que estiverem ligados
+	void setMaterialUniforms(const Material& material) const;
+	void bindTexture() const;
+	void bindVertexArray() const;
+	void drawBoundInstances(int instanceCount) const;
+	const glm::mat4& getModelMatrix() const { return model; }
+	Shader* getShader() const { return shader; }
+	GLuint getVAO() const { return VAO; }
+	GLuint getTextureID() const { return textureID; }
+	void setShader(Shader* shader) { this->shader = shader; }
+	//O nível 0 é a malha do initialize; os níveis adicionados devem ser cada vez mais
+	//simples e com maxScreenSize cada vez menor
+	void addLod(GLuint VAO, int nVertices, float maxScreenSize);
+	//Escolhe o nível pelo diâmetro na tela, com histerese, e passa a desenhá-lo (getVAO, drawBoundInstances...)
+	int selectLod(float screenSize, int view = 0);
+	void setLod(int lod);
+	int getLod() const { return lod; }
+	int getLodCount() const { return (int)lods.size(); }
+	const MeshLod& getLodLevel(int lod) const { return lods[lod]; }
 	void updatePosition(glm::vec3 position);
 	void setShouldRotateY(bool shouldRotateY);
+	void setRotationSpeed(float rotationSpeed);
 
 protected:
 	GLuint VAO; //Identificador do Vertex Array Object - Vértices e seus atributos
 	int nVertices;
 
+	//Níveis de detalhe; VAO e nVertices são os do nível em uso
+	std::vector <MeshLod> lods;
+	int lod;
+	int viewLods[MAX_LOD_VIEWS];
+
 	//Informações sobre as transformações a serem aplicadas no objeto
 	glm::vec3 position;
 	glm::vec3 scale;
 	float angle;
 	glm::vec3 axis;
+	glm::mat4 model; //Calculada em update
 
 	//Referência (endereço) do shader
 	Shader* shader;
@@ -35,5 +78,6 @@ protected:
 	GLuint textureID;
 
 	bool shouldRotateY = false;
+	float rotationSpeed = 0.06f; //Radianos por segundo
 };
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Culling por oclusão com uma pirâmide de profundidade (hierarchical-Z) feita
+// na CPU, sem ler nada da GPU (funciona também no modo headless).
+//
+// Os oclusores são rasterizados em um buffer pequeno de profundidade: cada
+// pixel guarda a distância da câmera (o w do clip space, que não depende de
+// reverse-Z) do oclusor mais próximo no centro do pixel. Os níveis seguintes
+// da pirâmide guardam a mais distante de cada bloco 2x2 do anterior. Um objeto
+// está oculto se a frente da sua esfera envolvente está atrás de tudo o que foi
+// rasterizado no retângulo que ela cobre na tela, lido no nível em que o
+// retângulo cabe em poucos texels.
+//
+// Os oclusores precisam estar dentro do objeto que representam (por exemplo o
+// nível de detalhe mais simples de uma malha convexa, já que os colapsos de meia
+// aresta mantêm os vértices na superfície original); triângulos que cruzam o
+// plano da câmera são ignorados, o que só deixa de esconder objetos.
+//
+//   culler.begin(camera.getViewProjectionMatrix());
+//   culler.addOccluder(occluderVertices, model);
+//   culler.buildPyramid();
+//   if (culler.isSphereOccluded(center, radius)) ...
+class OcclusionCuller
+{
+public:
+	static const int WIDTH = 256;
+	static const int HEIGHT = 128;
+	static const int VERTEX_FLOATS = 11; //Layout do parseOBJFile
+
+	OcclusionCuller();
+	//Começa uma view: limpa a profundidade
+	void begin(const glm::mat4& viewProjection);
+	//Vértices não indexados, 3 por triângulo, com a posição nos 3 primeiros floats
+	void addOccluder(const vector <float>& vertices, const glm::mat4& model, int vertexFloats = VERTEX_FLOATS);
+	//Depois de todos os oclusores da view
+	void buildPyramid();
+
+	bool isSphereOccluded(const glm::vec3& center, float radius) const;
+
+	int getLevelCount() const { return (int)levels.size(); }
+	//Triângulos rasterizados desde o begin
+	int getOccluderTriangles() const { return occluderTriangles; }
+
+protected:
+	void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+	glm::mat4 viewProjection;
+	vector <vector <float> > levels; //levels[0]: WIDTH x HEIGHT; cada nível seguinte tem metade em cada eixo
+	int occluderTriangles;
+};
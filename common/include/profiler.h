@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+using namespace std;
+
+struct ProfileEvent
+{
+	const char* name;
+	double start; //Microssegundos desde a criação do profiler
+	double duration;
+	int depth;
+	bool gpu;
+};
+
+struct ProfileStat
+{
+	string name;
+	float cpuMilliseconds; //Médias móveis, para o overlay não oscilar a cada frame
+	float gpuMilliseconds;
+};
+
+// Profiler de CPU e GPU. Escopos de CPU podem ser aninhados e são medidos
+// com steady_clock. Escopos de GPU usam queries GL_TIME_ELAPSED (que não
+// podem ser aninhadas) guardadas em um anel de QUERY_LATENCY frames, então
+// o resultado de um frame só é lido alguns frames depois, sem travar a GPU.
+// Os eventos podem ser exportados no formato de trace do Chrome
+// (chrome://tracing ou https://ui.perfetto.dev).
+class Profiler
+{
+public:
+	static const int QUERY_LATENCY = 4;
+
+	Profiler();
+	void initialize(bool gpuTimers = true);
+	void beginFrame();
+	void endFrame();
+	void beginCPU(const char* name);
+	void endCPU();
+	void beginGPU(const char* name);
+	void endGPU();
+	void setRecording(bool recording) { this->recording = recording; }
+	bool saveChromeTrace(const string& path);
+	void drawOverlay(int width, int height, float budgetMilliseconds = 1000.0f / 60.0f) const;
+	string getSummary() const;
+	const vector <ProfileStat>& getStats() const { return stats; }
+	void release();
+protected:
+	struct PendingQuery
+	{
+		GLuint query;
+		const char* name;
+		double start;
+	};
+	double now() const;
+	ProfileStat& getStat(const char* name);
+	void collectGPUQueries(int slot);
+	std::chrono::steady_clock::time_point origin;
+	bool gpuTimers;
+	bool recording;
+	int frame;
+	vector <ProfileEvent> trace;
+	vector <ProfileEvent> cpuStack;
+	vector <PendingQuery> pendingQueries[QUERY_LATENCY];
+	vector <GLuint> freeQueries;
+	PendingQuery activeQuery;
+	bool gpuScopeOpen;
+	vector <ProfileStat> stats;
+	map <string, int> statIndices;
+};
+
+// Mede o tempo de CPU (e opcionalmente de GPU) até o fim do bloco
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler& profiler, const char* name, bool gpu = false) : profiler(profiler), gpu(gpu)
+	{
+		profiler.beginCPU(name);
+		if (gpu)
+		{
+			profiler.beginGPU(name);
+		}
+	}
+	~ProfileScope()
+	{
+		if (gpu)
+		{
+			profiler.endGPU();
+		}
+		profiler.endCPU();
+	}
+protected:
+	Profiler& profiler;
+	bool gpu;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+#include "gl-stats.h"
+
+using namespace std;
+
+// Um draw da fila: o estado que ele precisa e um dado livre de quem o enviou
+struct RenderItem
+{
+	uint64_t key; //Calculada em RenderQueue::push
+	unsigned int pass; //Passos menores são executados antes
+	unsigned int program; //Ids da OpenGL (ou qualquer id estável do estado)
+	unsigned int material; //0: o draw não usa o estado (ex.: textura no pré-passo de profundidade)
+	unsigned int texture;
+	unsigned int vertexArray;
+	float depth; //Distância da câmera ao ponto mais próximo do objeto
+	unsigned int payload; //Ex.: índice do objeto na cena
+};
+
+// Estados que mudam entre dois draws (bits de `changes` em RenderQueue::execute)
+enum RenderState
+{
+	STATE_PASS,
+	STATE_PROGRAM,
+	STATE_MATERIAL, //Uniforms do material; trocar de programa também conta como trocar de material
+	STATE_TEXTURE,
+	STATE_VERTEX_ARRAY,
+	RENDER_STATE_COUNT
+};
+
+// Trocas de estado de uma fila: na ordem em que os draws foram enviados e na
+// ordem em que foram executados
+struct RenderQueueStats
+{
+	int draws;
+	int submitted[RENDER_STATE_COUNT];
+	int executed[RENDER_STATE_COUNT];
+
+	int getSubmittedTotal() const;
+	int getExecutedTotal() const;
+};
+
+// Fila de draws de uma view. Cada draw recebe uma chave de 64 bits e a fila é
+// ordenada por radix sort (8 passadas de 8 bits, estável e sem comparações),
+// então ordenar custa O(n) mesmo com milhares de draws. As passadas em que
+// todas as chaves têm o mesmo byte são puladas. Filas pequenas usam
+// std::stable_sort, que é mais rápido abaixo de ~350 draws (veja
+// --sort-benchmark). A ordem dos campos depende do SortMode do draw:
+//
+//   FRONT_TO_BACK   passo (3) | profundidade (28) | programa (9) | material (8) | textura (8) | VAO (8)
+//   BY_STATE        passo (3) | programa (9) | material (8) | textura (8) | VAO (8) | profundidade (28)
+//
+// A profundidade são os 28 bits altos de um float positivo, que têm a mesma
+// ordem do valor. Do mais próximo para o mais distante o teste de
+// profundidade descarta os fragmentos escondidos antes do fragment shader;
+// depois de um pré-passo de profundidade a ordem não importa mais para isso,
+// e agrupar por estado evita trocas de programa, uniforms, textura e VAO.
+//
+//   queue.clear();
+//   queue.push(item, RenderQueue::FRONT_TO_BACK);   //Para cada draw
+//   queue.sort();
+//   queue.execute([&](const RenderItem& item, unsigned int changes)
+//   {
+//       if (changes & (1u << STATE_PROGRAM)) ...    //Liga só o que mudou
+//   });
+class RenderQueue
+{
+public:
+	enum SortMode
+	{
+		FRONT_TO_BACK,
+		BY_STATE
+	};
+
+	static const int PASS_BITS = 3;
+	static const int DEPTH_BITS = 28;
+	static const int PROGRAM_BITS = 9;
+	static const int MATERIAL_BITS = 8;
+	static const int TEXTURE_BITS = 8;
+	static const int VERTEX_ARRAY_BITS = 8;
+	//A partir deste tamanho a fila é ordenada por radix sort
+	static const int RADIX_SORT_MIN = 384;
+
+	typedef std::function<void(const RenderItem&, unsigned int)> DrawFunction;
+
+	RenderQueue() { clear(); }
+	void clear();
+	void push(const RenderItem& item, SortMode order);
+	//minRadixCount: 0 sempre usa o radix sort (comparação no --sort-benchmark)
+	void sort(int minRadixCount = RADIX_SORT_MIN);
+	//Chama draw para cada item, na ordem da fila, com os bits dos estados que
+	//ele usa e que são diferentes do que está ligado (todos no primeiro)
+	void execute(const DrawFunction& draw);
+
+	int size() const { return (int)items.size(); }
+	const RenderItem& operator[](int i) const { return items[i]; }
+	const RenderQueueStats& getStats() const { return stats; }
+
+	//Os ids são truncados para os seus bits; ids diferentes que coincidem só ficam
+	//fora de ordem entre si (as trocas de estado usam os ids completos)
+	static uint64_t makeKey(SortMode order, const RenderItem& item);
+
+protected:
+	static void resetState(RenderItem& state);
+	//Bits dos estados de item diferentes de bound, que passa a ter o estado de item
+	static unsigned int updateState(RenderItem& bound, const RenderItem& item);
+	static void countChanges(unsigned int changes, int* counts);
+
+	vector <RenderItem> items;
+	vector <RenderItem> scratch; //Destino das passadas ímpares do radix sort
+	RenderItem submittedState; //Estado ligado se os draws fossem executados na ordem de envio
+	RenderQueueStats stats;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "transform-system.h"
+
+using namespace std;
+
+// Grafo de cena com transformações locais (relativas ao pai) e globais.
+//
+// Os nós ficam guardados em ordem de busca em largura: as raízes primeiro,
+// depois os filhos delas, e assim por diante. Assim todo pai vem antes dos
+// seus filhos e updateWorld() resolve a hierarquia inteira em uma única
+// passada linear pelos arrays. As transformações locais ficam em um
+// TransformSystem (SoA), na mesma ordem.
+//
+// Alterar a transformação local de um nó o marca como sujo; em updateWorld()
+// só são recalculados os nós sujos e os seus descendentes.
+//
+// Os nós são identificados por handles estáveis, que continuam válidos
+// quando a ordem interna muda (criação de nós ou troca de pai).
+class SceneGraph
+{
+public:
+	SceneGraph() : structureDirty(false), lastUpdateCount(0) {}
+	int createNode(int parent = -1, glm::vec3 position = glm::vec3(0.0f), glm::vec3 scale = glm::vec3(1.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	bool setParent(int node, int parent);
+	int getParent(int node) const { return parentHandles[node]; }
+	int size() const { return (int)indices.size(); }
+
+	void setPosition(int node, glm::vec3 position);
+	void setScale(int node, glm::vec3 scale);
+	void setRotation(int node, glm::quat rotation);
+	void setRotation(int node, float angle, glm::vec3 axis);
+	void rotate(int node, float angle, glm::vec3 axis);
+	const glm::vec3& getPosition(int node) const { return locals.getPosition(indices[node]); }
+
+	//Recalcula as matrizes globais dos nós sujos e dos seus descendentes
+	void updateWorld();
+	//Recalcula todos os nós, sujos ou não
+	void updateAllWorld();
+	//Válidas depois de updateWorld()
+	const glm::mat4& getWorldMatrix(int node) const { return world[indices[node]]; }
+	glm::vec3 getWorldPosition(int node) const { return glm::vec3(world[indices[node]][3]); }
+	//Número de nós recalculados no último updateWorld()
+	int getLastUpdateCount() const { return lastUpdateCount; }
+
+protected:
+	void markDirty(int node) { dirty[indices[node]] = 1; }
+	void rebuildOrder();
+
+	//Por handle
+	vector <int> parentHandles;
+	vector <int> indices; //Posição de cada nó nos arrays abaixo
+
+	//Em ordem de busca em largura
+	vector <int> handles;
+	vector <int> parents; //Índice do pai nestes arrays (-1 para raízes)
+	vector <char> dirty;
+	vector <glm::mat4> world;
+	TransformSystem locals;
+
+	bool structureDirty;
+	int lastUpdateCount;
+};
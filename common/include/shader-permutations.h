@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "material.h"
+
+using namespace std;
+
+// Recursos opcionais de um shader, ligados por #define na compilação
+enum ShaderFeature
+{
+	SHADER_TEXTURED = 1 << 0, //Amostra a textura difusa
+	SHADER_LIT = 1 << 1, //Iluminação ambiente + difusa (sem ela, só a cor do material)
+	SHADER_SPECULAR = 1 << 2, //Reflexão especular (só com SHADER_LIT)
+	SHADER_VERTEX_COLOR = 1 << 3, //Multiplica pela cor de cada vértice
+	SHADER_INSTANCED = 1 << 4, //Matriz model vinda do InstanceBuffer em vez do uniform
+	SHADER_CLUSTERED = 1 << 5, //Luzes pontuais dos froxels do LightClusters (só com SHADER_LIT)
+	SHADER_DEFERRED = 1 << 6, //Grava o G-buffer do DeferredRenderer em vez da cor iluminada
+	SHADER_FEATURE_COUNT = 7
+};
+
+// Variantes de um mesmo par de shaders, uma para cada combinação de recursos.
+// Cada variante é compilada (ou lida do cache de binários) só na primeira vez
+// em que é pedida, com os #define dos seus recursos:
+//
+//   #ifdef TEXTURED
+//       albedo = texture(tex_buffer, textureCoord).xyz;
+//   #endif
+//
+// A função de setup roda uma vez por variante criada, com o programa em uso e
+// os recursos da variante, para ligar uniform blocks e definir os uniforms
+// que não mudam.
+class ShaderPermutations
+{
+public:
+	typedef std::function<void(Shader&, unsigned int)> SetupFunction;
+
+	ShaderPermutations() {}
+	void initialize(const string& vertexPath, const string& fragmentPath, SetupFunction setup = SetupFunction());
+	//Pode trocar o programa em uso (quando a variante ainda não existe)
+	Shader* get(unsigned int features);
+	int getVariantCount() const { return (int)variants.size(); }
+	void release();
+
+	//A variante mais barata que ainda desenha o material corretamente
+	static unsigned int selectFeatures(const Material& material);
+	static string getDefines(unsigned int features);
+	static string getName(unsigned int features);
+
+protected:
+	string vertexPath;
+	string fragmentPath;
+	SetupFunction setup;
+	map <unsigned int, Shader*> variants;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Roda a simulação de cada frame (transformações, animações, culling) em uma
+// thread separada da thread da OpenGL. O resultado é escrito em um de dois
+// snapshots: enquanto a simulação do frame N escreve em um deles, a thread da
+// OpenGL desenha o snapshot do frame N-1 no outro, sem travas durante o uso.
+//
+//   simulation.submit(input);             //Começa o frame N na outra thread
+//   render(*snapshot);                     //Desenha o frame N-1
+//   if (simulation.hasPending())
+//       snapshot = &simulation.wait();     //Espera o frame N terminar
+//
+// O snapshot devolvido por wait() continua válido até o próximo submit()
+// depois do seguinte, quando o seu slot volta a ser escrito.
+template <typename Input, typename Snapshot>
+class SimulationThread
+{
+public:
+	typedef std::function<void(const Input&, Snapshot&)> StepFunction;
+
+	SimulationThread() : running(false), busy(false), pending(false), writeSlot(0) {}
+	~SimulationThread() { stop(); }
+
+	void start(StepFunction step)
+	{
+		this->step = step;
+		running = true;
+		worker = std::thread(&SimulationThread::run, this);
+	}
+
+	void submit(const Input& input)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this] { return !busy; });
+		this->input = input;
+		busy = true;
+		pending = true;
+		workCondition.notify_one();
+	}
+
+	const Snapshot& wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [this] { return !busy; });
+		pending = false;
+		return snapshots[1 - writeSlot];
+	}
+
+	//Há um frame enviado cujo snapshot ainda não foi retirado com wait()
+	bool hasPending() const { return pending; }
+
+	void stop()
+	{
+		if (!worker.joinable())
+		{
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			doneCondition.wait(lock, [this] { return !busy; });
+			running = false;
+			workCondition.notify_one();
+		}
+
+		worker.join();
+	}
+
+protected:
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true)
+		{
+			workCondition.wait(lock, [this] { return busy || !running; });
+
+			if (!running)
+			{
+				return;
+			}
+
+			//A simulação roda sem o mutex: a outra thread só lê o outro slot
+			Snapshot& snapshot = snapshots[writeSlot];
+			lock.unlock();
+			step(input, snapshot);
+			lock.lock();
+
+			writeSlot = 1 - writeSlot;
+			busy = false;
+			doneCondition.notify_all();
+		}
+	}
+
+	StepFunction step;
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable workCondition;
+	std::condition_variable doneCondition;
+	bool running;
+	bool busy;
+	bool pending; //Só é usado pela thread que chama submit/wait
+	int writeSlot;
+	Input input;
+	Snapshot snapshots[2];
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using namespace std;
+
+// Transformações de todos os objetos da cena guardadas em arrays contíguos
+// (SoA): posições, rotações e escalas ficam cada uma no seu array, e as
+// matrizes model são calculadas para um intervalo inteiro de objetos de uma
+// vez, escritas direto no destino (normalmente um instance buffer mapeado).
+//
+//   int moon = transforms.create(glm::vec3(-1, 0, 0), glm::vec3(0.1f));
+//   transforms.rotate(moon, speed * deltaTime, glm::vec3(0, 1, 0));
+//   transforms.computeModels(0, transforms.size(), instances.map());
+//
+// Um objeto pode ter um pai (criado antes dele); a sua matriz é então
+// relativa à do pai.
+class TransformSystem
+{
+public:
+	TransformSystem() {}
+	int create(glm::vec3 position = glm::vec3(0.0f), glm::vec3 scale = glm::vec3(1.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), int parent = -1);
+	int size() const { return (int)positions.size(); }
+
+	void setPosition(int object, glm::vec3 position) { positions[object] = position; }
+	void setScale(int object, glm::vec3 scale) { scales[object] = scale; }
+	void setRotation(int object, glm::quat rotation) { rotations[object] = rotation; }
+	void setRotation(int object, float angle, glm::vec3 axis);
+	void rotate(int object, float angle, glm::vec3 axis);
+
+	const glm::vec3& getPosition(int object) const { return positions[object]; }
+	const glm::vec3& getScale(int object) const { return scales[object]; }
+	const glm::quat& getRotation(int object) const { return rotations[object]; }
+	int getParent(int object) const { return parents[object]; }
+
+	//Escreve em models[i] a matriz model dos objetos [begin, end); models só é
+	//escrito, nunca lido, então pode apontar para memória mapeada da OpenGL.
+	//Intervalos diferentes podem ser calculados em paralelo.
+	void computeModels(int begin, int end, glm::mat4* models) const;
+	glm::mat4 computeModel(int object) const;
+
+protected:
+	glm::mat4 computeLocal(int object) const;
+
+	vector <glm::vec3> positions;
+	vector <glm::quat> rotations;
+	vector <glm::vec3> scales;
+	vector <int> parents; //-1 para objetos sem pai
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "bvh.h"
+
+using namespace std;
+
+// Acerto de um raio em uma malha
+struct RayHit
+{
+	int triangle; //Índice do triângulo na malha de entrada, -1 se o raio não acertou nada
+	float distance; //Ao longo do raio (em unidades da direção, normalizada ou não)
+	float u, v; //Coordenadas baricêntricas: ponto = v0 + u * (v1 - v0) + v * (v2 - v0)
+};
+
+// Nó de 4 filhos, com as caixas em SoA para testar as quatro com um raio em uma
+// única passada SIMD
+struct TriangleBvhNode
+{
+	float minX[4], minY[4], minZ[4];
+	float maxX[4], maxY[4], maxZ[4];
+	int children[4]; //counts 0: índice do nó filho; > 0: primeiro triângulo da folha
+	int counts[4]; //Triângulos da folha, 0 nos nós internos e -1 nos filhos que não existem
+};
+
+// BVH dos triângulos de uma malha, para lançar raios contra ela (seleção com o
+// mouse, colisão). A árvore é construída pelo SAH do Bvh sobre as caixas dos
+// triângulos e depois achatada em nós de 4 filhos, tirando os netos dos filhos
+// com maior área. Os triângulos ficam na ordem das folhas, em SoA (v0 e as
+// arestas e1 e e2), e são testados 4 por vez (Möller-Trumbore).
+//
+// As operações de 4 floats usam SSE em x86, NEON em ARM de 64 bits e um laço
+// escalar nas outras arquiteturas. raycastScalar percorre a árvore binária e
+// testa um triângulo por vez, para comparação (veja --ray-benchmark).
+//
+//   TriangleBvh bvh;
+//   bvh.build(parsedObj.vertices);
+//   RayHit hit;
+//   if (bvh.raycast(origin, direction, FLT_MAX, hit)) ...   //Raio em coordenadas do modelo
+class TriangleBvh
+{
+public:
+	static const int VERTEX_FLOATS = 11; //Layout do parseOBJFile
+
+	TriangleBvh() {}
+	//Vértices não indexados, 3 por triângulo, com a posição nos 3 primeiros floats
+	void build(const vector <float>& vertices, int vertexFloats = VERTEX_FLOATS);
+
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+	//Quatro raios percorrem a árvore juntos: cada nó é testado contra os quatro de uma
+	//vez. Compensa para raios coerentes, como os de pixels vizinhos
+	void raycastPacket(const glm::vec3* origins, const glm::vec3* directions, float maxDistance, RayHit* hits) const;
+	bool raycastScalar(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+	int getTriangleCount() const { return (int)triangleIds.size(); }
+	int getNodeCount() const { return (int)nodes.size(); }
+	const Bvh& getBinaryBvh() const { return binary; }
+
+	//Möller-Trumbore de um triângulo, nas duas faces. Retorna a distância ou -1
+	static float intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
+		float maxDistance, float& u, float& v);
+
+protected:
+	int convertNode(int binaryNode);
+	void setChild(TriangleBvhNode& node, int lane, const BvhNode* child);
+
+	Bvh binary;
+	vector <TriangleBvhNode> nodes;
+
+	//Triângulos na ordem das folhas, com 3 triângulos vazios no fim para as leituras de 4
+	vector <float> v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z;
+	vector <int> triangleIds;
+	vector <int> triangleSlots; //Posição de cada triângulo da malha nos arrays acima
+};
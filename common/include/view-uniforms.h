@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Shader.h"
+#include "camera.h"
+
+using namespace std;
+
+// Conteúdo do uniform block "View" (layout std140, mesma ordem dos shaders):
+//
+//   layout (std140) uniform View
+//   {
+//       mat4 view;
+//       mat4 projection;
+//       mat4 viewProjection;
+//       vec4 cameraPos;
+//   };
+struct ViewBlock
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 cameraPos;
+};
+
+// Uniform buffer com as matrizes de várias views (tela dividida, views de
+// sombra...). Cada câmera é publicada uma única vez no seu slot e todos os
+// programas ligados com attach() leem o slot ativo, escolhido com bind().
+// Um slot só é reenviado quando a revisão da câmera muda.
+class ViewUniforms
+{
+public:
+	//Ponto de ligação do block "View" (o GLSL 4.10 não tem layout(binding = ...))
+	static const GLuint BINDING = 0;
+
+	ViewUniforms() : UBO(0), stride(0), maxViews(0) {}
+	void initialize(int maxViews);
+	void attach(const Shader& shader, const char* blockName = "View") const;
+	void update(int view, const Camera& camera);
+	void bind(int view) const;
+	void release();
+
+protected:
+	GLuint UBO;
+	GLint stride; //Tamanho de cada slot, respeitando GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	int maxViews;
+	vector <const Camera*> cameras;
+	vector <unsigned int> revisions;
+};
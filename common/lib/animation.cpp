@@ -0,0 +1,345 @@
+#include "animation.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t ANIMATION_FILE_VERSION = 1;
+
+static size_t getAnimationFileSize(uint32_t trackCount, uint32_t keyCount)
+{
+	return sizeof(AnimationFileHeader) + trackCount * sizeof(AnimationTrackInfo) + keyCount * (1 + 3 + 4 + 3) * sizeof(float);
+}
+
+//Escreve a chave k nas seções de chaves (SoA) de um bloco de dados
+static void writeKeyframe(const AnimationKeyframe& key, size_t k, float* times, float* positions, float* rotations, float* scales)
+{
+	times[k] = key.time;
+	memcpy(positions + k * 3, &key.position[0], 3 * sizeof(float));
+	rotations[k * 4 + 0] = key.rotation.x;
+	rotations[k * 4 + 1] = key.rotation.y;
+	rotations[k * 4 + 2] = key.rotation.z;
+	rotations[k * 4 + 3] = key.rotation.w;
+	memcpy(scales + k * 3, &key.scale[0], 3 * sizeof(float));
+}
+
+AnimationClip::AnimationClip()
+	: mapped(NULL), mappedSize(0), header(NULL), tracks(NULL), times(NULL), positions(NULL), rotations(NULL), scales(NULL)
+{
+}
+
+AnimationClip::~AnimationClip()
+{
+	unload();
+}
+
+void AnimationClip::bindSections(const char* data)
+{
+	header = (const AnimationFileHeader*)data;
+	tracks = (const AnimationTrackInfo*)(data + sizeof(AnimationFileHeader));
+	times = (const float*)(tracks + header->trackCount);
+	positions = times + header->keyCount;
+	rotations = positions + header->keyCount * 3;
+	scales = rotations + header->keyCount * 4;
+}
+
+void AnimationClip::unload()
+{
+#ifndef _WIN32
+	if (mapped)
+	{
+		munmap(mapped, mappedSize);
+	}
+#endif
+	mapped = NULL;
+	mappedSize = 0;
+	ownedData.clear();
+	header = NULL;
+	tracks = NULL;
+	times = positions = rotations = scales = NULL;
+}
+
+int AnimationClip::addTrack(const vector <AnimationKeyframe>& keyframes)
+{
+	uint32_t oldTrackCount = getNbTracks();
+	uint32_t oldKeyCount = header ? header->keyCount : 0;
+	uint32_t trackCount = oldTrackCount + 1;
+	uint32_t keyCount = oldKeyCount + keyframes.size();
+
+	//Reconstrói o bloco de dados com a nova trilha no final de cada seção
+	vector <char> data(getAnimationFileSize(trackCount, keyCount));
+
+	AnimationFileHeader* newHeader = (AnimationFileHeader*)data.data();
+	memcpy(newHeader->magic, "ANIM", 4);
+	newHeader->version = ANIMATION_FILE_VERSION;
+	newHeader->trackCount = trackCount;
+	newHeader->keyCount = keyCount;
+	newHeader->duration = getDuration();
+
+	AnimationTrackInfo* newTracks = (AnimationTrackInfo*)(data.data() + sizeof(AnimationFileHeader));
+	float* newTimes = (float*)(newTracks + trackCount);
+	float* newPositions = newTimes + keyCount;
+	float* newRotations = newPositions + keyCount * 3;
+	float* newScales = newRotations + keyCount * 4;
+
+	if (header)
+	{
+		memcpy(newTracks, tracks, oldTrackCount * sizeof(AnimationTrackInfo));
+		memcpy(newTimes, times, oldKeyCount * sizeof(float));
+		memcpy(newPositions, positions, oldKeyCount * 3 * sizeof(float));
+		memcpy(newRotations, rotations, oldKeyCount * 4 * sizeof(float));
+		memcpy(newScales, scales, oldKeyCount * 3 * sizeof(float));
+	}
+
+	newTracks[oldTrackCount].firstKey = oldKeyCount;
+	newTracks[oldTrackCount].keyCount = keyframes.size();
+
+	for (size_t i = 0; i < keyframes.size(); i++)
+	{
+		writeKeyframe(keyframes[i], oldKeyCount + i, newTimes, newPositions, newRotations, newScales);
+		newHeader->duration = max(newHeader->duration, keyframes[i].time);
+	}
+
+	unload();
+	ownedData.swap(data);
+	bindSections(ownedData.data());
+
+	return oldTrackCount;
+}
+
+void AnimationClip::build(const vector <vector <AnimationKeyframe> >& trackKeyframes)
+{
+	uint32_t trackCount = trackKeyframes.size();
+	uint32_t keyCount = 0;
+
+	for (size_t track = 0; track < trackKeyframes.size(); track++)
+	{
+		keyCount += trackKeyframes[track].size();
+	}
+
+	//O bloco é alocado uma vez com o tamanho final e cada seção é preenchida em sequência
+	vector <char> data(getAnimationFileSize(trackCount, keyCount));
+
+	AnimationFileHeader* newHeader = (AnimationFileHeader*)data.data();
+	memcpy(newHeader->magic, "ANIM", 4);
+	newHeader->version = ANIMATION_FILE_VERSION;
+	newHeader->trackCount = trackCount;
+	newHeader->keyCount = keyCount;
+	newHeader->duration = 0.0f;
+
+	AnimationTrackInfo* newTracks = (AnimationTrackInfo*)(data.data() + sizeof(AnimationFileHeader));
+	float* newTimes = (float*)(newTracks + trackCount);
+	float* newPositions = newTimes + keyCount;
+	float* newRotations = newPositions + keyCount * 3;
+	float* newScales = newRotations + keyCount * 4;
+
+	uint32_t k = 0;
+	for (uint32_t track = 0; track < trackCount; track++)
+	{
+		const vector <AnimationKeyframe>& keyframes = trackKeyframes[track];
+		newTracks[track].firstKey = k;
+		newTracks[track].keyCount = keyframes.size();
+
+		for (size_t i = 0; i < keyframes.size(); i++, k++)
+		{
+			writeKeyframe(keyframes[i], k, newTimes, newPositions, newRotations, newScales);
+			newHeader->duration = max(newHeader->duration, keyframes[i].time);
+		}
+	}
+
+	unload();
+	ownedData.swap(data);
+	bindSections(ownedData.data());
+}
+
+bool AnimationClip::save(const string& path) const
+{
+	if (!header)
+	{
+		return false;
+	}
+
+	ofstream file(path.c_str(), ios::binary);
+
+	if (!file.is_open())
+	{
+		cout << "Failed to open file: " << path << endl;
+		return false;
+	}
+
+	file.write((const char*)header, getAnimationFileSize(header->trackCount, header->keyCount));
+	return file.good();
+}
+
+bool AnimationClip::load(const string& path)
+{
+	unload();
+
+	const char* data = NULL;
+	size_t size = 0;
+
+#ifndef _WIN32
+	//O arquivo é mapeado direto em memória, as páginas só são lidas quando acessadas
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+	{
+		cout << "Failed to open file: " << path << endl;
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(AnimationFileHeader))
+	{
+		mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (mapped == MAP_FAILED)
+		{
+			mapped = NULL;
+		}
+		else
+		{
+			mappedSize = info.st_size;
+			data = (const char*)mapped;
+			size = mappedSize;
+		}
+	}
+
+	close(fd);
+#else
+	ifstream file(path.c_str(), ios::binary | ios::ate);
+
+	if (!file.is_open())
+	{
+		cout << "Failed to open file: " << path << endl;
+		return false;
+	}
+
+	ownedData.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read(ownedData.data(), ownedData.size());
+	data = ownedData.data();
+	size = ownedData.size();
+#endif
+
+	const AnimationFileHeader* fileHeader = (const AnimationFileHeader*)data;
+
+	if (!data || size < sizeof(AnimationFileHeader) || memcmp(fileHeader->magic, "ANIM", 4) != 0 || fileHeader->version != ANIMATION_FILE_VERSION || size < getAnimationFileSize(fileHeader->trackCount, fileHeader->keyCount))
+	{
+		cout << "ERROR::ANIMATION::INVALID_FILE " << path << endl;
+		unload();
+		return false;
+	}
+
+	bindSections(data);
+
+	//Cada trilha precisa caber nas chaves do arquivo e ter os tempos em ordem (o sampler faz busca binária)
+	for (uint32_t track = 0; track < header->trackCount; track++)
+	{
+		uint32_t first = tracks[track].firstKey;
+		uint32_t count = tracks[track].keyCount;
+		bool valid = (uint64_t)first + count <= header->keyCount;
+
+		for (uint32_t key = 1; valid && key < count; key++)
+		{
+			valid = times[first + key - 1] <= times[first + key];
+		}
+
+		if (!valid)
+		{
+			cout << "ERROR::ANIMATION::INVALID_TRACK " << track << " " << path << endl;
+			unload();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AnimationSampler::initialize(const AnimationClip* clip, bool looping)
+{
+	this->clip = clip;
+	this->looping = looping;
+	cursors.assign(clip->getNbTracks(), 0);
+}
+
+void AnimationSampler::sample(float time, glm::vec3* outPositions, glm::quat* outRotations, glm::vec3* outScales)
+{
+	const AnimationTrackInfo* tracks = clip->getTracks();
+	const float* times = clip->getTimes();
+	const glm::vec3* positions = clip->getPositions();
+	const glm::quat* rotations = clip->getRotations();
+	const glm::vec3* scales = clip->getScales();
+	float duration = clip->getDuration();
+	int nTracks = clip->getNbTracks();
+
+	if (looping && duration > 0.0f)
+	{
+		time = fmod(time, duration);
+
+		if (time < 0.0f)
+		{
+			time += duration;
+		}
+	}
+
+	for (int track = 0; track < nTracks; track++)
+	{
+		uint32_t first = tracks[track].firstKey;
+		uint32_t count = tracks[track].keyCount;
+
+		if (count == 0)
+		{
+			outPositions[track] = glm::vec3(0.0f);
+			outRotations[track] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			outScales[track] = glm::vec3(1.0f);
+			continue;
+		}
+
+		const float* trackTimes = times + first;
+		uint32_t cursor = min(cursors[track], count - 1);
+
+		if (trackTimes[cursor] > time)
+		{
+			//O tempo voltou (loop ou seek): busca binária pela chave
+			cursor = upper_bound(trackTimes, trackTimes + count, time) - trackTimes;
+			cursor = cursor > 0 ? cursor - 1 : 0;
+		}
+		else
+		{
+			while (cursor + 1 < count && trackTimes[cursor + 1] <= time)
+			{
+				cursor++;
+			}
+		}
+
+		cursors[track] = cursor;
+
+		uint32_t a = first + cursor;
+
+		if (cursor + 1 >= count || time <= trackTimes[cursor])
+		{
+			outPositions[track] = positions[a];
+			outRotations[track] = rotations[a];
+			outScales[track] = scales[a];
+			continue;
+		}
+
+		uint32_t b = a + 1;
+		float alpha = (time - times[a]) / (times[b] - times[a]);
+
+		outPositions[track] = glm::mix(positions[a], positions[b], alpha);
+		outRotations[track] = glm::slerp(rotations[a], rotations[b], alpha);
+		outScales[track] = glm::mix(scales[a], scales[b], alpha);
+	}
+}
@@ -0,0 +1,558 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static const int FRUSTUM_PLANES = 6;
+
+//Custo de visitar um nó em relação ao de testar um item (SAH)
+static const float TRAVERSAL_COST = 1.0f;
+//Componentes da direção menores que isso são tratados como paralelos ao eixo
+static const float MIN_DIRECTION = 1e-30f;
+
+struct BvhBin
+{
+	glm::vec3 min, max;
+	int count;
+};
+
+static float getArea(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+void Bvh::build(const glm::vec3* mins, const glm::vec3* maxs, int count)
+{
+	nodes.clear();
+	depth = 0;
+	itemIds.resize(count);
+	itemMins.assign(mins, mins + count);
+	itemMaxs.assign(maxs, maxs + count);
+	for (int i = 0; i < count; i++)
+	{
+		itemIds[i] = i;
+	}
+
+	if (count > 0)
+	{
+		//Uma árvore binária com n folhas tem 2n - 1 nós: o vetor nunca é realocado
+		nodes.reserve(2 * count);
+		BvhNode root;
+		root.leftFirst = 0;
+		root.count = count;
+		nodes.push_back(root);
+		updateBounds(0);
+		subdivide(0, 1);
+	}
+}
+
+void Bvh::refit(const glm::vec3* mins, const glm::vec3* maxs)
+{
+	for (int slot = 0; slot < (int)itemIds.size(); slot++)
+	{
+		itemMins[slot] = mins[itemIds[slot]];
+		itemMaxs[slot] = maxs[itemIds[slot]];
+	}
+
+	//Os filhos vêm sempre depois do pai, então de trás para frente cada nó já tem os filhos prontos
+	for (int node = (int)nodes.size() - 1; node >= 0; node--)
+	{
+		updateBounds(node);
+	}
+}
+
+void Bvh::subdivide(int node, int level)
+{
+	depth = std::max(depth, level);
+
+	int first = nodes[node].leftFirst;
+	int count = nodes[node].count;
+	if (count <= 1 || level >= MAX_DEPTH)
+	{
+		return;
+	}
+
+	//Os cortes são feitos pelos centros dos itens (aqui min + max, o dobro do centro)
+	glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+	for (int slot = first; slot < first + count; slot++)
+	{
+		glm::vec3 center = itemMins[slot] + itemMaxs[slot];
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+
+	int bestAxis = -1, bestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centerMax[axis] - centerMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		BvhBin bins[BIN_COUNT];
+		for (int bin = 0; bin < BIN_COUNT; bin++)
+		{
+			bins[bin].min = glm::vec3(FLT_MAX);
+			bins[bin].max = glm::vec3(-FLT_MAX);
+			bins[bin].count = 0;
+		}
+
+		float scale = BIN_COUNT / extent;
+		for (int slot = first; slot < first + count; slot++)
+		{
+			float center = itemMins[slot][axis] + itemMaxs[slot][axis];
+			int bin = std::min(BIN_COUNT - 1, (int)((center - centerMin[axis]) * scale));
+			bins[bin].min = glm::min(bins[bin].min, itemMins[slot]);
+			bins[bin].max = glm::max(bins[bin].max, itemMaxs[slot]);
+			bins[bin].count++;
+		}
+
+		//Área e número de itens à esquerda e à direita de cada um dos BIN_COUNT - 1 cortes
+		float leftCost[BIN_COUNT - 1];
+		glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+		int leftCount = 0;
+		for (int split = 0; split < BIN_COUNT - 1; split++)
+		{
+			leftCount += bins[split].count;
+			boxMin = glm::min(boxMin, bins[split].min);
+			boxMax = glm::max(boxMax, bins[split].max);
+			leftCost[split] = leftCount > 0 ? leftCount * getArea(boxMin, boxMax) : 0.0f;
+		}
+
+		boxMin = glm::vec3(FLT_MAX);
+		boxMax = glm::vec3(-FLT_MAX);
+		int rightCount = 0;
+		for (int split = BIN_COUNT - 1; split > 0; split--)
+		{
+			rightCount += bins[split].count;
+			boxMin = glm::min(boxMin, bins[split].min);
+			boxMax = glm::max(boxMax, bins[split].max);
+
+			//Cortes com um dos lados vazio não dividem nada
+			if (rightCount == 0 || rightCount == count)
+			{
+				continue;
+			}
+			float cost = leftCost[split - 1] + rightCount * getArea(boxMin, boxMax);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	int middle;
+	if (bestAxis < 0)
+	{
+		//Todos os centros coincidem: nenhum corte separa os itens, só a metade por índice
+		if (count <= MAX_LEAF_SIZE)
+		{
+			return;
+		}
+		middle = first + count / 2;
+	}
+	else
+	{
+		//Custo esperado de dividir contra o de testar todos os itens da folha
+		float parentArea = getArea(nodes[node].min, nodes[node].max);
+		float splitCost = TRAVERSAL_COST + (parentArea > 0.0f ? bestCost / parentArea : (float)count);
+		if (splitCost >= count && count <= MAX_LEAF_SIZE)
+		{
+			return;
+		}
+
+		float scale = BIN_COUNT / (centerMax[bestAxis] - centerMin[bestAxis]);
+		int i = first, j = first + count - 1;
+		while (i <= j)
+		{
+			float center = itemMins[i][bestAxis] + itemMaxs[i][bestAxis];
+			int bin = std::min(BIN_COUNT - 1, (int)((center - centerMin[bestAxis]) * scale));
+			if (bin < bestSplit)
+			{
+				i++;
+			}
+			else
+			{
+				std::swap(itemIds[i], itemIds[j]);
+				std::swap(itemMins[i], itemMins[j]);
+				std::swap(itemMaxs[i], itemMaxs[j]);
+				j--;
+			}
+		}
+		middle = i;
+	}
+
+	int left = (int)nodes.size();
+	BvhNode child;
+	child.leftFirst = first;
+	child.count = middle - first;
+	nodes.push_back(child);
+	child.leftFirst = middle;
+	child.count = first + count - middle;
+	nodes.push_back(child);
+
+	nodes[node].leftFirst = left;
+	nodes[node].count = 0;
+
+	updateBounds(left);
+	updateBounds(left + 1);
+	subdivide(left, level + 1);
+	subdivide(left + 1, level + 1);
+}
+
+void Bvh::updateBounds(int node)
+{
+	BvhNode& current = nodes[node];
+
+	if (current.count == 0)
+	{
+		const BvhNode& left = nodes[current.leftFirst];
+		const BvhNode& right = nodes[current.leftFirst + 1];
+		current.min = glm::min(left.min, right.min);
+		current.max = glm::max(left.max, right.max);
+		return;
+	}
+
+	current.min = glm::vec3(FLT_MAX);
+	current.max = glm::vec3(-FLT_MAX);
+	for (int slot = current.leftFirst; slot < current.leftFirst + current.count; slot++)
+	{
+		current.min = glm::min(current.min, itemMins[slot]);
+		current.max = glm::max(current.max, itemMaxs[slot]);
+	}
+}
+
+void Bvh::addSubtree(int node, vector <int>& items) const
+{
+	//Os itens de uma subárvore são contíguos: da primeira folha à esquerda até a última à direita
+	int leftmost = node, rightmost = node;
+	while (nodes[leftmost].count == 0)
+	{
+		leftmost = nodes[leftmost].leftFirst;
+	}
+	while (nodes[rightmost].count == 0)
+	{
+		rightmost = nodes[rightmost].leftFirst + 1;
+	}
+
+	int first = nodes[leftmost].leftFirst;
+	int last = nodes[rightmost].leftFirst + nodes[rightmost].count;
+	items.insert(items.end(), itemIds.begin() + first, itemIds.begin() + last);
+}
+
+void Bvh::queryFrustum(const glm::vec4* planes, vector <int>& items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	//Cada entrada da pilha leva os planos que ainda cortam o nó: os filhos de um nó
+	//totalmente dentro de um plano não precisam ser testados contra ele
+	int stack[MAX_DEPTH * 2];
+	unsigned int masks[MAX_DEPTH * 2];
+	int size = 0;
+	stack[size] = 0;
+	masks[size++] = (1u << FRUSTUM_PLANES) - 1;
+
+	while (size > 0)
+	{
+		size--;
+		const BvhNode& node = nodes[stack[size]];
+		unsigned int mask = masks[size];
+		bool outside = false;
+
+		for (int i = 0; i < FRUSTUM_PLANES && !outside; i++)
+		{
+			if (!(mask & (1u << i)))
+			{
+				continue;
+			}
+
+			//Vértices da caixa mais à frente e mais atrás na direção da normal
+			glm::vec3 normal = glm::vec3(planes[i]);
+			glm::vec3 positive(normal.x >= 0.0f ? node.max.x : node.min.x, normal.y >= 0.0f ? node.max.y : node.min.y, normal.z >= 0.0f ? node.max.z : node.min.z);
+			glm::vec3 negative(normal.x >= 0.0f ? node.min.x : node.max.x, normal.y >= 0.0f ? node.min.y : node.max.y, normal.z >= 0.0f ? node.min.z : node.max.z);
+
+			if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+			{
+				outside = true;
+			}
+			else if (glm::dot(normal, negative) + planes[i].w >= 0.0f)
+			{
+				mask &= ~(1u << i);
+			}
+		}
+
+		if (outside)
+		{
+			continue;
+		}
+
+		if (mask == 0)
+		{
+			addSubtree(stack[size], items);
+		}
+		else if (node.count > 0)
+		{
+			for (int slot = node.leftFirst; slot < node.leftFirst + node.count; slot++)
+			{
+				bool visible = true;
+				for (int i = 0; i < FRUSTUM_PLANES && visible; i++)
+				{
+					glm::vec3 normal = glm::vec3(planes[i]);
+					glm::vec3 positive(normal.x >= 0.0f ? itemMaxs[slot].x : itemMins[slot].x, normal.y >= 0.0f ? itemMaxs[slot].y : itemMins[slot].y, normal.z >= 0.0f ? itemMaxs[slot].z : itemMins[slot].z);
+					visible = !((mask & (1u << i)) && glm::dot(normal, positive) + planes[i].w < 0.0f);
+				}
+				if (visible)
+				{
+					items.push_back(itemIds[slot]);
+				}
+			}
+		}
+		else
+		{
+			stack[size] = node.leftFirst;
+			masks[size++] = mask;
+			stack[size] = node.leftFirst + 1;
+			masks[size++] = mask;
+		}
+	}
+}
+
+void Bvh::queryBox(const glm::vec3& min, const glm::vec3& max, vector <int>& items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	int stack[MAX_DEPTH * 2];
+	int size = 0;
+	stack[size++] = 0;
+
+	while (size > 0)
+	{
+		int index = stack[--size];
+		const BvhNode& node = nodes[index];
+
+		if (glm::any(glm::lessThan(node.max, min)) || glm::any(glm::greaterThan(node.min, max)))
+		{
+			continue;
+		}
+
+		//Caixa do nó toda dentro da consulta: todos os itens dele entram
+		if (glm::all(glm::greaterThanEqual(node.min, min)) && glm::all(glm::lessThanEqual(node.max, max)))
+		{
+			addSubtree(index, items);
+		}
+		else if (node.count > 0)
+		{
+			for (int slot = node.leftFirst; slot < node.leftFirst + node.count; slot++)
+			{
+				if (!glm::any(glm::lessThan(itemMaxs[slot], min)) && !glm::any(glm::greaterThan(itemMins[slot], max)))
+				{
+					items.push_back(itemIds[slot]);
+				}
+			}
+		}
+		else
+		{
+			stack[size++] = node.leftFirst;
+			stack[size++] = node.leftFirst + 1;
+		}
+	}
+}
+
+void Bvh::querySphere(const glm::vec3& center, float radius, vector <int>& items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	float radiusSquared = radius * radius;
+	int stack[MAX_DEPTH * 2];
+	int size = 0;
+	stack[size++] = 0;
+
+	while (size > 0)
+	{
+		int index = stack[--size];
+		const BvhNode& node = nodes[index];
+
+		//Ponto da caixa mais próximo do centro
+		glm::vec3 closest = glm::clamp(center, node.min, node.max);
+		glm::vec3 offset = closest - center;
+		if (glm::dot(offset, offset) > radiusSquared)
+		{
+			continue;
+		}
+
+		//O canto mais distante dentro da esfera: a caixa inteira está dentro
+		glm::vec3 farthest = glm::max(glm::abs(node.min - center), glm::abs(node.max - center));
+		if (glm::dot(farthest, farthest) <= radiusSquared)
+		{
+			addSubtree(index, items);
+		}
+		else if (node.count > 0)
+		{
+			for (int slot = node.leftFirst; slot < node.leftFirst + node.count; slot++)
+			{
+				glm::vec3 itemOffset = glm::clamp(center, itemMins[slot], itemMaxs[slot]) - center;
+				if (glm::dot(itemOffset, itemOffset) <= radiusSquared)
+				{
+					items.push_back(itemIds[slot]);
+				}
+			}
+		}
+		else
+		{
+			stack[size++] = node.leftFirst;
+			stack[size++] = node.leftFirst + 1;
+		}
+	}
+}
+
+int Bvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance, const RayFunction& intersect) const
+{
+	distance = maxDistance;
+	if (nodes.empty())
+	{
+		return -1;
+	}
+
+	glm::vec3 inverseDirection = getInverseDirection(direction);
+	int hit = -1;
+
+	//Os nós ficam na pilha com a distância de entrada, para serem pulados se um
+	//acerto mais próximo aparecer depois que foram empilhados
+	int stack[MAX_DEPTH * 2];
+	float entries[MAX_DEPTH * 2];
+	int size = 0;
+
+	float rootEntry = intersectBox(nodes[0].min, nodes[0].max, origin, inverseDirection, distance);
+	if (rootEntry < 0.0f)
+	{
+		return -1;
+	}
+	stack[size] = 0;
+	entries[size++] = rootEntry;
+
+	while (size > 0)
+	{
+		size--;
+		if (entries[size] > distance)
+		{
+			continue;
+		}
+
+		const BvhNode& node = nodes[stack[size]];
+		if (node.count > 0)
+		{
+			for (int slot = node.leftFirst; slot < node.leftFirst + node.count; slot++)
+			{
+				float itemDistance = intersectBox(itemMins[slot], itemMaxs[slot], origin, inverseDirection, distance);
+				if (itemDistance >= 0.0f && intersect)
+				{
+					itemDistance = intersect(itemIds[slot], distance);
+				}
+				if (itemDistance >= 0.0f && itemDistance < distance)
+				{
+					distance = itemDistance;
+					hit = itemIds[slot];
+				}
+			}
+			continue;
+		}
+
+		int nearChild = node.leftFirst, farChild = node.leftFirst + 1;
+		float nearEntry = intersectBox(nodes[nearChild].min, nodes[nearChild].max, origin, inverseDirection, distance);
+		float farEntry = intersectBox(nodes[farChild].min, nodes[farChild].max, origin, inverseDirection, distance);
+		if (farEntry >= 0.0f && (nearEntry < 0.0f || farEntry < nearEntry))
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearEntry, farEntry);
+		}
+
+		//O mais próximo é empilhado por último, para ser visitado primeiro
+		if (farEntry >= 0.0f)
+		{
+			stack[size] = farChild;
+			entries[size++] = farEntry;
+		}
+		if (nearEntry >= 0.0f)
+		{
+			stack[size] = nearChild;
+			entries[size++] = nearEntry;
+		}
+	}
+
+	return hit;
+}
+
+glm::vec3 Bvh::getInverseDirection(const glm::vec3& direction)
+{
+	//Um raio paralelo a um eixo e no plano de uma caixa daria 0 * infinito (NaN) nos slabs
+	glm::vec3 inverse;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		inverse[axis] = fabs(direction[axis]) > MIN_DIRECTION ? 1.0f / direction[axis] : (direction[axis] < 0.0f ? -1.0f : 1.0f) / MIN_DIRECTION;
+	}
+	return inverse;
+}
+
+float Bvh::intersectBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	//Slabs: o raio está dentro da caixa entre a maior entrada e a menor saída dos três eixos
+	glm::vec3 t0 = (min - origin) * inverseDirection;
+	glm::vec3 t1 = (max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
+
+float Bvh::intersectSphere(const glm::vec3& center, float radius, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+	//t^2 - 2bt + c = 0, com b a projeção do centro no raio
+	glm::vec3 offset = center - origin;
+	float b = glm::dot(offset, direction);
+	float c = glm::dot(offset, offset) - radius * radius;
+	float discriminant = b * b - c;
+	if (discriminant < 0.0f)
+	{
+		return -1.0f;
+	}
+
+	//Com a origem dentro da esfera (c < 0) o raio já começa nela
+	float distance = c < 0.0f ? 0.0f : b - sqrt(discriminant);
+	return distance >= 0.0f && distance <= maxDistance ? distance : -1.0f;
+}
+
+float Bvh::getSahCost() const
+{
+	if (nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	//Cada nó é visitado com a probabilidade da sua área em relação à raiz
+	float cost = 0.0f;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		float area = getArea(nodes[i].min, nodes[i].max);
+		cost += area * (nodes[i].count > 0 ? (float)nodes[i].count : TRAVERSAL_COST);
+	}
+
+	float rootArea = getArea(nodes[0].min, nodes[0].max);
+	return rootArea > 0.0f ? cost / rootArea : cost;
+}
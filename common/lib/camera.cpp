@@ -3,6 +3,12 @@
 void Camera::initialize(Shader* shader, int width, int height, float sensitivity, float pitch, float yaw, glm::vec3 cameraFront, glm::vec3 cameraPos, glm::vec3 cameraUp)
 {
 	firstMouse = true;
+	movementSpeed = 3.0f;
+	acceleration = 30.0f;
+	damping = 10.0f;
+	velocity = glm::vec3(0.0f);
+	mouseDeltaX = mouseDeltaY = 0.0f;
+	moveForward = moveBackward = moveLeft = moveRight = false;
 	this->shader = shader;
 	this->sensitivity = sensitivity;
 	this->pitch = pitch;
@@ -10,14 +16,17 @@ void Camera::initialize(Shader* shader, int width, int height, float sensitivity
 	this->cameraFront = cameraFront;
 	this->cameraPos = cameraPos;
 	this->cameraUp = cameraUp;
+	this->aspectRatio = (float)width / (float)height;
+	fovy = 45.0f;
+	nearPlane = 0.1f;
+	farPlane = 100.0f;
+	reverseZ = false;
+	revision = 0;
 
-	//Matriz de view -- posição e orientação da câmera
-	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	shader->setMat4("view", value_ptr(view));
-
-	//Matriz de projeção perspectiva - definindo o volume de visualização (frustum)
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader->setMat4("projection", glm::value_ptr(projection));
+	//A orientação inicial vem de cameraFront, pitch/yaw só são aplicados quando o mouse mexer
+	orientationDirty = false;
+	viewDirty = projectionDirty = true;
+	updateMatrices();
 }
 
 void Camera::rotate(GLFWwindow* window, double xpos, double ypos)
@@ -29,52 +38,288 @@ void Camera::rotate(GLFWwindow* window, double xpos, double ypos)
 		firstMouse = false;
 	}
 
-	float offsetx = xpos - lastX;
-	float offsety = lastY - ypos;
+	//Os deslocamentos do mouse são acumulados e aplicados de uma vez em update,
+	//então vários eventos no mesmo frame custam uma única atualização do vetor front
+	mouseDeltaX += xpos - lastX;
+	mouseDeltaY += lastY - ypos;
 
 	lastX = xpos;
 	lastY = ypos;
+}
+
+void Camera::pollKeys(GLFWwindow* window)
+{
+	//Lê o estado atual das teclas, sem depender da taxa de repetição do sistema
+	moveForward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+	moveBackward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+	moveLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+	moveRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+}
+
+void Camera::update(float deltaTime) {
+	if (mouseDeltaX != 0.0f || mouseDeltaY != 0.0f)
+	{
+		yaw += mouseDeltaX * sensitivity;
+		pitch = glm::clamp(pitch + mouseDeltaY * sensitivity, -89.0f, 89.0f);
+		mouseDeltaX = mouseDeltaY = 0.0f;
+		orientationDirty = true;
+	}
+
+	if (orientationDirty)
+	{
+		glm::vec3 front;
+		front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+		front.y = sin(glm::radians(pitch));
+		front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+		cameraFront = glm::normalize(front);
+		orientationDirty = false;
+		viewDirty = true;
+	}
+
+	//As teclas aceleram a câmera e o amortecimento a freia; a velocidade
+	//máxima (acceleration / damping) é limitada a movementSpeed
+	if (deltaTime > 0.0f)
+	{
+		glm::vec3 right = glm::normalize(glm::cross(cameraFront, cameraUp));
+		glm::vec3 direction(0.0f);
+
+		if (moveForward)
+		{
+			direction += cameraFront;
+		}
+		if (moveBackward)
+		{
+			direction -= cameraFront;
+		}
+		if (moveLeft)
+		{
+			direction -= right;
+		}
+		if (moveRight)
+		{
+			direction += right;
+		}
+
+		if (glm::length(direction) > 0.0f)
+		{
+			velocity += glm::normalize(direction) * acceleration * deltaTime;
+		}
+
+		//Amortecimento exponencial, o mesmo para qualquer taxa de frames
+		velocity *= exp(-damping * deltaTime);
+
+		float speed = glm::length(velocity);
+		if (speed > movementSpeed)
+		{
+			velocity *= movementSpeed / speed;
+		}
+		else if (speed < 0.001f)
+		{
+			velocity = glm::vec3(0.0f);
+		}
+
+		if (velocity != glm::vec3(0.0f))
+		{
+			cameraPos += velocity * deltaTime;
+			viewDirty = true;
+		}
+	}
+
+	updateMatrices();
+}
 
-	offsetx *= sensitivity;
-	offsety *= sensitivity;
+void Camera::resize(int width, int height)
+{
+	if (width <= 0 || height <= 0)
+	{
+		return;
+	}
 
-	pitch += offsety;
-	yaw += offsetx;
+	float aspectRatio = (float)width / (float)height;
 
-	glm::vec3 front;
-	front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-	front.y = sin(glm::radians(pitch));
-	front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-	cameraFront = glm::normalize(front);
+	if (aspectRatio != this->aspectRatio)
+	{
+		this->aspectRatio = aspectRatio;
+		projectionDirty = true;
+	}
 }
 
-void Camera::update() {
-	//Atualizando a posição e orientação da câmera
-	glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-	shader->setMat4("view", glm::value_ptr(view));
+void Camera::setPerspective(float fovy, float nearPlane, float farPlane)
+{
+	this->fovy = fovy;
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+	projectionDirty = true;
+}
 
-	//Atualizando o shader com a posição da câmera
-	shader->setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
+void Camera::setReverseZ(bool reverseZ)
+{
+	//Exige glDepthFunc(GL_GREATER) e glClearDepth(0.0), de preferência com
+	//glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE) e um depth buffer em float
+	this->reverseZ = reverseZ;
+	projectionDirty = true;
+}
+
+void Camera::updateMatrices()
+{
+	if (!viewDirty && !projectionDirty)
+	{
+		return;
+	}
+
+	if (viewDirty)
+	{
+		//Atualizando a posição e orientação da câmera
+		view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+
+		if (shader)
+		{
+			shader->setMat4("view", glm::value_ptr(view));
+
+			//Atualizando o shader com a posição da câmera
+			shader->setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
+		}
+	}
+
+	if (projectionDirty)
+	{
+		//Matriz de projeção perspectiva - definindo o volume de visualização (frustum)
+		if (reverseZ)
+		{
+			//z_ndc = near / -z_view: 1 no plano near, tendendo a 0 no infinito (farPlane é ignorado).
+			//Como a profundidade em float tem mais precisão perto de 0, o erro relativo fica
+			//praticamente constante com a distância, em vez de crescer com o quadrado dela.
+			float f = 1.0f / tan(glm::radians(fovy) / 2.0f);
+			projection = glm::mat4(0.0f);
+			projection[0][0] = f / aspectRatio;
+			projection[1][1] = f;
+			projection[2][3] = -1.0f;
+			projection[3][2] = nearPlane;
+		}
+		else
+		{
+			projection = glm::perspective(glm::radians(fovy), aspectRatio, nearPlane, farPlane);
+		}
+
+		if (shader)
+		{
+			shader->setMat4("projection", glm::value_ptr(projection));
+		}
+	}
+
+	viewProjection = projection * view;
+
+	//Extrai os planos do frustum das linhas da matriz viewProjection (Gribb/Hartmann),
+	//com a normal apontando para dentro: um ponto p está dentro se dot(plano, (p, 1)) >= 0
+	glm::mat4 m = glm::transpose(viewProjection);
+	frustumPlanes[FRUSTUM_LEFT] = m[3] + m[0];
+	frustumPlanes[FRUSTUM_RIGHT] = m[3] - m[0];
+	frustumPlanes[FRUSTUM_BOTTOM] = m[3] + m[1];
+	frustumPlanes[FRUSTUM_TOP] = m[3] - m[1];
+	if (reverseZ)
+	{
+		//Com reverse-Z o near é z_ndc <= 1 e o far (z_ndc >= 0) fica no infinito
+		frustumPlanes[FRUSTUM_NEAR] = m[3] - m[2];
+		frustumPlanes[FRUSTUM_FAR] = m[2];
+	}
+	else
+	{
+		frustumPlanes[FRUSTUM_NEAR] = m[3] + m[2];
+		frustumPlanes[FRUSTUM_FAR] = m[3] - m[2];
+	}
+
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		float length = glm::length(glm::vec3(frustumPlanes[i]));
+
+		//O far infinito não tem normal e não recorta nada
+		frustumPlanes[i] = length > 0.0f ? frustumPlanes[i] / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	viewDirty = projectionDirty = false;
+	revision++;
+}
+
+bool Camera::isSphereInFrustum(const glm::vec4* planes, const glm::vec3& center, float radius)
+{
+	//Recebe uma cópia dos planos para poder ser usado fora da thread da câmera
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Camera::isBoxVisible(const glm::vec3& min, const glm::vec3& max) const
+{
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		//Testa só o vértice da caixa mais à frente na direção da normal do plano
+		glm::vec3 normal = glm::vec3(frustumPlanes[i]);
+		glm::vec3 positive(normal.x >= 0.0f ? max.x : min.x, normal.y >= 0.0f ? max.y : min.y, normal.z >= 0.0f ? max.z : min.z);
+
+		if (glm::dot(normal, positive) + frustumPlanes[i].w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+float Camera::getProjectedDiameter(const glm::vec3& center, float radius, float viewportHeight) const
+{
+	//A esfera ocupa o ângulo asin(r / d) em volta do centro: de dentro dela, a tela toda
+	float distance = glm::length(center - cameraPos);
+	if (distance <= radius)
+	{
+		return viewportHeight;
+	}
+
+	float tangent = radius / sqrt(distance * distance - radius * radius);
+	return viewportHeight * tangent / tan(glm::radians(fovy) * 0.5f);
+}
+
+void Camera::getRay(float x, float y, float width, float height, glm::vec3& origin, glm::vec3& direction) const
+{
+	//Pelos eixos da câmera, sem desprojetar: vale para qualquer profundidade (inclusive reverse-Z)
+	float ndcX = 2.0f * x / width - 1.0f;
+	float ndcY = 1.0f - 2.0f * y / height;
+	float tangent = tan(glm::radians(fovy) * 0.5f);
+
+	glm::vec3 right = glm::normalize(glm::cross(cameraFront, cameraUp));
+	glm::vec3 up = glm::cross(right, cameraFront);
+
+	origin = cameraPos;
+	direction = glm::normalize(cameraFront + right * (ndcX * tangent * aspectRatio) + up * (ndcY * tangent));
 }
 
 void Camera::move(GLFWwindow* window, int key, int action)
 {
-	float cameraSpeed = 0.1;
+	//Apenas registra quais teclas estão pressionadas, o deslocamento é feito em update
+	if (action == GLFW_REPEAT)
+	{
+		return;
+	}
+
+	bool pressed = action == GLFW_PRESS;
 
 	if (key == GLFW_KEY_W)
 	{
-		cameraPos += cameraFront * cameraSpeed;
+		moveForward = pressed;
 	}
 	if (key == GLFW_KEY_S)
 	{
-		cameraPos -= cameraFront * cameraSpeed;
+		moveBackward = pressed;
 	}
 	if (key == GLFW_KEY_A)
 	{
-		cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+		moveLeft = pressed;
 	}
 	if (key == GLFW_KEY_D)
 	{
-		cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+		moveRight = pressed;
 	}
 }
@@ -0,0 +1,100 @@
+#include "curve-batch.h"
+
+void CurveBatch::initialize(Shader* shader, const Curve& curveType, int nControlPointsPerCurve, int pointsPerSegment, int maxCurves)
+{
+	this->shader = shader;
+	this->M = curveType.getBasisMatrix();
+	this->segmentStride = curveType.getSegmentStride();
+	this->nControlPointsPerCurve = nControlPointsPerCurve;
+	this->pointsPerSegment = pointsPerSegment;
+	this->maxCurves = maxCurves;
+	this->nCurves = 0;
+
+	//Cada segmento usa 4 pontos de controle e o próximo começa segmentStride pontos depois
+	nSegments = (nControlPointsPerCurve - 4) / segmentStride + 1;
+
+	//Aloca o espaço de todas as curvas de uma só vez, sem enviar dados
+	glGenBuffers(1, &TBO);
+	glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+	glBufferData(GL_TEXTURE_BUFFER, maxCurves * nControlPointsPerCurve * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, TBO);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	//No core profile é obrigatório ter um VAO vinculado mesmo sem atributos
+	glGenVertexArrays(1, &VAO);
+}
+
+int CurveBatch::addCurve(const vector <glm::vec3>& controlPoints)
+{
+	if (nCurves >= maxCurves || (int)controlPoints.size() != nControlPointsPerCurve)
+	{
+		std::cout << "ERROR::CURVE_BATCH::INVALID_CURVE" << std::endl;
+		return -1;
+	}
+
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, nControlPointsPerCurve * sizeof(glm::vec3));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+	glBufferSubData(GL_TEXTURE_BUFFER, nCurves * nControlPointsPerCurve * sizeof(glm::vec3), nControlPointsPerCurve * sizeof(glm::vec3), controlPoints.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	return nCurves++;
+}
+
+void CurveBatch::setControlPoint(int curve, int i, glm::vec3 point)
+{
+	if (curve < 0 || curve >= nCurves || i < 0 || i >= nControlPointsPerCurve)
+	{
+		std::cout << "ERROR::CURVE_BATCH::INVALID_CONTROL_POINT " << curve << " " << i << std::endl;
+		return;
+	}
+
+	//Apenas o ponto editado é reenviado, a curva é reavaliada no vertex shader
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, sizeof(glm::vec3));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+	glBufferSubData(GL_TEXTURE_BUFFER, (curve * nControlPointsPerCurve + i) * sizeof(glm::vec3), sizeof(glm::vec3), glm::value_ptr(point));
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void CurveBatch::drawCurves(glm::vec4 color)
+{
+	shader->Use();
+	shader->setMat4("basis", glm::value_ptr(M));
+	shader->setInt("controlPointsPerCurve", nControlPointsPerCurve);
+	shader->setInt("segmentStride", segmentStride);
+	shader->setInt("nSegments", nSegments);
+	shader->setInt("pointsPerSegment", pointsPerSegment);
+	shader->setInt("controlPoints", 0);
+	shader->setVec4("finalColor", color.r, color.g, color.b, color.a);
+
+	GL_STATS_COUNT(STAT_TEXTURE_BINDS);
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+	GL_STATS_COUNT(STAT_DRAW_CALLS);
+	GL_STATS_ADD(STAT_VERTICES, getNbVerticesPerCurve() * nCurves);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glBindVertexArray(VAO);
+	// Cada instância é uma curva, desenhada como um GL_LINE_STRIP independente
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, getNbVerticesPerCurve(), nCurves);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void CurveBatch::release()
+{
+	if (TBO)
+	{
+		glDeleteTextures(1, &texture);
+		glDeleteBuffers(1, &TBO);
+		glDeleteVertexArrays(1, &VAO);
+		TBO = texture = VAO = 0;
+	}
+}
@@ -6,10 +6,137 @@ void Curve::setShader(Shader* shader)
 	shader->Use();
 }
 
+void Curve::evaluateSegment(int segment)
+{
+	glm::vec3 P0 = controlPoints[segment * segmentStride];
+	glm::vec3 P1 = controlPoints[segment * segmentStride + 1];
+	glm::vec3 P2 = controlPoints[segment * segmentStride + 2];
+	glm::vec3 P3 = controlPoints[segment * segmentStride + 3];
+
+	glm::mat4x3 G(P0, P1, P2, P3);
+
+	// Cada segmento ocupa sempre pointsPerSegment + 1 posições em curvePoints,
+	// assim um segmento pode ser reavaliado sem deslocar os demais
+	int first = segment * (pointsPerSegment + 1);
+
+	for (int j = 0; j <= pointsPerSegment; j++)
+	{
+		float t = (float)j / (float)pointsPerSegment;
+
+		glm::vec4 T(t * t * t, t * t, t, 1);
+
+		curvePoints[first + j] = G * M * T;
+	}
+}
+
+glm::vec3 Curve::evaluate(float u) const
+{
+	//u percorre a curva inteira em [0, 1) e volta ao início depois disso
+	int nSegments = getNbSegments();
+
+	//Com menos de 4 pontos de controle não há segmento para avaliar
+	if (nSegments == 0)
+	{
+		return controlPoints.empty() ? glm::vec3(0.0f) : controlPoints[0];
+	}
+
+	float position = (u - glm::floor(u)) * nSegments;
+	int segment = glm::min((int)position, nSegments - 1);
+	float t = position - segment;
+
+	glm::mat4x3 G(controlPoints[segment * segmentStride], controlPoints[segment * segmentStride + 1], controlPoints[segment * segmentStride + 2], controlPoints[segment * segmentStride + 3]);
+	glm::vec4 T(t * t * t, t * t, t, 1);
+
+	return G * M * T;
+}
+
+void Curve::generateCurve(int pointsPerSegment)
+{
+	this->pointsPerSegment = pointsPerSegment;
+
+	int nSegments = getNbSegments();
+
+	curvePoints.assign(nSegments * (pointsPerSegment + 1), glm::vec3(0.0));
+
+	for (int segment = 0; segment < nSegments; segment++)
+	{
+		evaluateSegment(segment);
+	}
+
+	//Gera o VAO apenas na primeira vez, as próximas chamadas reaproveitam os mesmos buffers
+	if (!VAO)
+	{
+		//Geração do identificador do VBO
+		glGenBuffers(1, &VBO);
+
+		//Geração do identificador do VAO (Vertex Array Object)
+		glGenVertexArrays(1, &VAO);
+
+		// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
+		// e os ponteiros para os atributos
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+		//Atributo posição (x, y, z)
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+
+		// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
+		glBindVertexArray(0);
+	}
+
+	//Envia os dados do array de floats para o buffer da OpenGl
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, curvePoints.size() * sizeof(GLfloat) * 3);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, curvePoints.size() * sizeof(GLfloat) * 3, curvePoints.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Curve::setControlPoint(int i, glm::vec3 point)
+{
+	controlPoints[i] = point;
+
+	if (!VAO)
+	{
+		return;
+	}
+
+	//O segmento s usa os pontos de controle [s * segmentStride, s * segmentStride + 3]
+	int firstSegment = glm::max(0, (i - 3 + segmentStride - 1) / segmentStride);
+	int lastSegment = glm::min(getNbSegments() - 1, i / segmentStride);
+
+	if (firstSegment > lastSegment)
+	{
+		return;
+	}
+
+	for (int segment = firstSegment; segment <= lastSegment; segment++)
+	{
+		evaluateSegment(segment);
+	}
+
+	//Reenvia apenas o trecho de curvePoints que foi reavaliado
+	int first = firstSegment * (pointsPerSegment + 1);
+	int count = (lastSegment - firstSegment + 1) * (pointsPerSegment + 1);
+
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, count * sizeof(glm::vec3));
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), &curvePoints[first]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Curve::drawCurve(glm::vec4 color)
 {
 	shader->setVec4("finalColor", color.r, color.g, color.b, color.a);
 
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+	GL_STATS_COUNT(STAT_DRAW_CALLS);
+	GL_STATS_ADD(STAT_VERTICES, curvePoints.size());
+
 	glBindVertexArray(VAO);
 	// Chamada de desenho - drawcall
 	// CONTORNO e PONTOS - GL_LINE_LOOP e GL_POINTS
@@ -17,4 +144,14 @@ void Curve::drawCurve(glm::vec4 color)
 	//glDrawArrays(GL_POINTS, 0, curvePoints.size());
 	glBindVertexArray(0);
 
+}
+
+void Curve::release()
+{
+	if (VAO)
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		VAO = VBO = 0;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "deferred-renderer.h"
+
+static const float ZERO[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+static const int TEXTURE_COUNT = 8;
+//Índices em textures depois das cores do G-buffer
+static const int DEPTH_TEXTURE = DeferredRenderer::GBUFFER_COLORS;
+static const int LIGHTING_TEXTURE = DEPTH_TEXTURE + 1;
+static const int DEPTH_COPY_TEXTURE = DEPTH_TEXTURE + 2;
+//Sampler e unidade de cada textura, na ordem de textures (a cópia da profundidade não é lida)
+static const int SAMPLER_COUNT = 7;
+static const char* SAMPLERS[SAMPLER_COUNT] = { "gAlbedo", "gNormal", "gAmbient", "gDiffuse", "gSpecular", "gDepth", "lightAccumulation" };
+static const int UNITS[SAMPLER_COUNT] = { DeferredRenderer::ALBEDO_UNIT, DeferredRenderer::NORMAL_UNIT, DeferredRenderer::AMBIENT_UNIT, DeferredRenderer::DIFFUSE_UNIT,
+	DeferredRenderer::SPECULAR_UNIT, DeferredRenderer::DEPTH_UNIT, DeferredRenderer::LIGHTING_UNIT };
+
+void DeferredRenderer::initialize(int width, int height, Shader* lightingShader, Shader* compositeShader)
+{
+	this->width = width;
+	this->height = height;
+	this->lightingShader = lightingShader;
+	this->compositeShader = compositeShader;
+
+	//Albedo, normal, ka, kd, ks, profundidade, luzes somadas e a cópia da profundidade
+	GLenum internalFormats[TEXTURE_COUNT] = { GL_RGBA8, GL_RGBA16F, GL_RGBA16F, GL_RGBA16F, GL_RGBA16F, GL_DEPTH_COMPONENT32F, GL_RGBA16F, GL_DEPTH_COMPONENT32F };
+	GLenum formats[TEXTURE_COUNT] = { GL_RGBA, GL_RGBA, GL_RGBA, GL_RGBA, GL_RGBA, GL_DEPTH_COMPONENT, GL_RGBA, GL_DEPTH_COMPONENT };
+	GLenum types[TEXTURE_COUNT] = { GL_UNSIGNED_BYTE, GL_FLOAT, GL_FLOAT, GL_FLOAT, GL_FLOAT, GL_FLOAT, GL_FLOAT, GL_FLOAT };
+
+	//Os FBOs são criados sem desligar o framebuffer em que a cena é desenhada
+	GLint previousFBO;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+
+	glGenTextures(TEXTURE_COUNT, textures);
+	for (int i = 0; i < TEXTURE_COUNT; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, formats[i], types[i], NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &gBufferFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, gBufferFBO);
+	//As saídas 0 a 4 dos shaders DEFERRED (os draw buffers fazem parte do estado do FBO)
+	GLenum drawBuffers[GBUFFER_COLORS];
+	for (int i = 0; i < GBUFFER_COLORS; i++)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[DEPTH_TEXTURE], 0);
+	glDrawBuffers(GBUFFER_COLORS, drawBuffers);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::DEFERRED_RENDERER::GBUFFER_INCOMPLETE" << std::endl;
+	}
+
+	glGenFramebuffers(1, &lightingFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, lightingFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[LIGHTING_TEXTURE], 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[DEPTH_COPY_TEXTURE], 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::DEFERRED_RENDERER::LIGHTING_INCOMPLETE" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+
+	//O perfil core não desenha sem um VAO ligado, mesmo sem atributos
+	glGenVertexArrays(1, &emptyVAO);
+
+	//Os samplers ficam sempre nas mesmas unidades (os que o shader não usa são ignorados)
+	Shader* shaders[2] = { lightingShader, compositeShader };
+
+	for (int shader = 0; shader < 2; shader++)
+	{
+		shaders[shader]->Use();
+		for (int i = 0; i < SAMPLER_COUNT; i++)
+		{
+			shaders[shader]->setInt(SAMPLERS[i], UNITS[i]);
+		}
+	}
+}
+
+void DeferredRenderer::beginGeometry()
+{
+	//A composição volta para o framebuffer que estava ligado e usa o mesmo valor de limpeza da profundidade
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &outputFBO);
+	glGetFloatv(GL_DEPTH_CLEAR_VALUE, &clearDepth);
+
+	//Só a profundidade é limpa: os pixels sem geometria são reconhecidos por ela e
+	//as outras texturas nunca são lidas nesses pixels
+	glBindFramebuffer(GL_FRAMEBUFFER, gBufferFBO);
+	glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+}
+
+void DeferredRenderer::accumulateLights(const Camera& camera, glm::vec4 viewport)
+{
+	//O shader lê a profundidade do G-buffer, então o teste usa uma cópia dela
+	//(uma textura ligada ao FBO e lida ao mesmo tempo não tem resultado definido)
+	int x0 = (int)viewport.x, y0 = (int)viewport.y, x1 = (int)(viewport.x + viewport.z), y1 = (int)(viewport.y + viewport.w);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, gBufferFBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lightingFBO);
+	glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, lightingFBO);
+	glClearBufferfv(GL_COLOR, 0, ZERO);
+
+	//Sem as luzes somadas, que são o alvo deste passo
+	bindTextures(GBUFFER_COLORS + 1);
+
+	lightingShader->Use();
+
+	glm::mat4 inverseViewProjection = glm::inverse(camera.getViewProjectionMatrix());
+	lightingShader->setMat4("inverseViewProjection", glm::value_ptr(inverseViewProjection));
+	lightingShader->setVec4("viewport", viewport.x, viewport.y, viewport.z, viewport.w);
+
+	//z em NDC = profundidade * escala + bias
+	if (zeroToOneDepth)
+	{
+		lightingShader->setVec2("depthToNdc", 1.0f, 0.0f);
+	}
+	else
+	{
+		lightingShader->setVec2("depthToNdc", 2.0f, -1.0f);
+	}
+
+	//O triângulo fica na profundidade do fundo: só passa onde há geometria na frente dele
+	GLint depthFunc;
+	glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+	glDepthFunc(clearDepth < 0.5f ? GL_LESS : GL_GREATER);
+	glDepthMask(GL_FALSE);
+
+	drawFullscreen(*lightingShader, zeroToOneDepth ? clearDepth : clearDepth * 2.0f - 1.0f);
+
+	glDepthMask(GL_TRUE);
+	glDepthFunc(depthFunc);
+}
+
+void DeferredRenderer::composite()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+	bindTextures(GBUFFER_COLORS + 2);
+
+	compositeShader->Use();
+	compositeShader->setFloat("clearDepth", clearDepth);
+
+	//A profundidade do G-buffer é copiada para a saída, então o que for desenhado
+	//depois (a órbita) continua sendo escondido pela cena
+	GLint depthFunc;
+	glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+	glDepthFunc(GL_ALWAYS);
+
+	drawFullscreen(*compositeShader, 0.0f);
+
+	glDepthFunc(depthFunc);
+}
+
+void DeferredRenderer::drawFullscreen(Shader& shader, float depth) const
+{
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+	GL_STATS_COUNT(STAT_DRAW_CALLS);
+	GL_STATS_ADD(STAT_VERTICES, 3);
+
+	//z em NDC de todo o triângulo
+	shader.setFloat("fullscreenDepth", depth);
+
+	glBindVertexArray(emptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+void DeferredRenderer::bindTextures(int count) const
+{
+	GL_STATS_ADD(STAT_TEXTURE_BINDS, count);
+
+	for (int i = 0; i < count; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + UNITS[i]);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void DeferredRenderer::release()
+{
+	if (gBufferFBO)
+	{
+		glDeleteFramebuffers(1, &gBufferFBO);
+		glDeleteFramebuffers(1, &lightingFBO);
+		glDeleteTextures(TEXTURE_COUNT, textures);
+		glDeleteVertexArrays(1, &emptyVAO);
+		gBufferFBO = 0;
+	}
+}
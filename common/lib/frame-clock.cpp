@@ -0,0 +1,57 @@
+#include "frame-clock.h"
+
+FrameClock::FrameClock()
+{
+	initialize();
+}
+
+void FrameClock::initialize(float fixedStep, float maxDelta)
+{
+	this->fixedStep = fixedStep;
+	this->maxDelta = maxDelta;
+	started = false;
+	paused = false;
+	timeScale = 1.0f;
+	fixedDelta = 0.0f;
+	deltaTime = 0.0f;
+	realDeltaTime = 0.0f;
+	accumulator = 0.0f;
+	time = 0.0;
+	frameIndex = 0;
+}
+
+void FrameClock::tick()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	float measured = started ? std::chrono::duration<float>(now - lastTick).count() : 0.0f;
+
+	lastTick = now;
+	started = true;
+
+	tick(fixedDelta > 0.0f ? fixedDelta : measured);
+}
+
+void FrameClock::tick(float realDelta)
+{
+	if (realDelta > maxDelta)
+	{
+		realDelta = maxDelta;
+	}
+
+	realDeltaTime = realDelta;
+	deltaTime = paused ? 0.0f : realDelta * timeScale;
+	accumulator += deltaTime;
+	time += deltaTime;
+	frameIndex++;
+}
+
+bool FrameClock::stepFixed()
+{
+	if (accumulator < fixedStep)
+	{
+		return false;
+	}
+
+	accumulator -= fixedStep;
+	return true;
+}
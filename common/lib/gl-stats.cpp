@@ -0,0 +1,96 @@
+#include "gl-stats.h"
+
+#include <algorithm>
+#include <sstream>
+
+void GLStats::setWindowSize(int frames)
+{
+	windowSize = max(frames, 1);
+	history.clear();
+	framesRecorded = 0;
+	nextFrame = 0;
+}
+
+void GLStats::endFrame()
+{
+	if (history.empty())
+	{
+		history.assign(windowSize * STAT_COUNT, 0);
+	}
+
+	//Guarda o frame na posição mais antiga da janela e zera os contadores
+	for (int i = 0; i < STAT_COUNT; i++)
+	{
+		history[nextFrame * STAT_COUNT + i] = current[i];
+		current[i] = 0;
+	}
+
+	nextFrame = (nextFrame + 1) % windowSize;
+	framesRecorded = min(framesRecorded + 1, windowSize);
+}
+
+unsigned long GLStats::getMin(GLStat stat) const
+{
+	if (framesRecorded == 0)
+	{
+		return 0;
+	}
+
+	unsigned long value = history[stat];
+	for (int frame = 1; frame < framesRecorded; frame++)
+	{
+		value = min(value, history[frame * STAT_COUNT + stat]);
+	}
+	return value;
+}
+
+unsigned long GLStats::getMax(GLStat stat) const
+{
+	unsigned long value = 0;
+	for (int frame = 0; frame < framesRecorded; frame++)
+	{
+		value = max(value, history[frame * STAT_COUNT + stat]);
+	}
+	return value;
+}
+
+double GLStats::getAverage(GLStat stat) const
+{
+	if (framesRecorded == 0)
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (int frame = 0; frame < framesRecorded; frame++)
+	{
+		total += history[frame * STAT_COUNT + stat];
+	}
+	return total / framesRecorded;
+}
+
+const char* GLStats::getName(GLStat stat)
+{
+	static const char* names[STAT_COUNT] = {
+		"draws", "vertices", "uniforms", "uniform bytes", "texture binds",
+		"vao binds", "buffer uploads", "buffer bytes", "program binds", "state changes",
+		"changes avoided"
+	};
+	return names[stat];
+}
+
+string GLStats::getSummary() const
+{
+	//Uma linha por categoria: "draws min/avg/max"
+	ostringstream summary;
+	summary.setf(ios::fixed);
+	summary.precision(1);
+
+	for (int i = 0; i < STAT_COUNT; i++)
+	{
+		GLStat stat = (GLStat)i;
+		summary << getName(stat) << " " << getMin(stat) << "/" << getAverage(stat) << "/" << getMax(stat) << endl;
+	}
+
+	return summary.str();
+}
@@ -0,0 +1,87 @@
+#include "instance-buffer.h"
+
+void InstanceBuffer::initialize(int maxInstances)
+{
+	this->maxInstances = maxInstances;
+
+	glGenBuffers(2, buffers);
+
+	for (int i = 0; i < 2; i++)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, maxInstances * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+glm::mat4* InstanceBuffer::map()
+{
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, maxInstances * sizeof(glm::mat4));
+
+	//INVALIDATE: o conteúdo anterior é descartado, então o driver não precisa esperar
+	//os draws que ainda leem este buffer (ele entrega outra área de memória)
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[writeSlot]);
+	mapped = (glm::mat4*)glMapBufferRange(GL_ARRAY_BUFFER, 0, maxInstances * sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (!mapped)
+	{
+		std::cout << "ERROR::INSTANCE_BUFFER::MAP_FAILED" << std::endl;
+	}
+
+	return mapped;
+}
+
+void InstanceBuffer::unmap()
+{
+	if (!mapped)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[writeSlot]);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	mapped = NULL;
+
+	//O buffer recém-escrito passa a ser o dos draws
+	drawSlot = writeSlot;
+	writeSlot = 1 - writeSlot;
+}
+
+void InstanceBuffer::attach(GLuint VAO, int firstInstance) const
+{
+	//Sem glDrawArraysInstancedBaseInstance (OpenGL 4.2), a primeira instância de cada
+	//malha é escolhida pelo offset do atributo no VAO
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[drawSlot]);
+
+	for (int column = 0; column < 4; column++)
+	{
+		GLuint location = MODEL_LOCATION + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::release()
+{
+	if (mapped)
+	{
+		unmap();
+	}
+
+	if (maxInstances > 0)
+	{
+		glDeleteBuffers(2, buffers);
+		maxInstances = 0;
+	}
+}
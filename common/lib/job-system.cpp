@@ -0,0 +1,238 @@
+#include "job-system.h"
+
+#include <algorithm>
+
+//Índice da fila da thread atual (0 para a thread principal e threads de fora do sistema)
+static thread_local int currentQueue = 0;
+//Ponto de partida da busca por filas para roubar, diferente em cada thread
+static thread_local unsigned int stealSeed = 0;
+
+void JobSystem::initialize(int workerCount)
+{
+	if (workerCount < 0)
+	{
+		workerCount = max(1, (int)std::thread::hardware_concurrency()) - 1;
+	}
+
+	for (int i = 0; i <= workerCount; i++)
+	{
+		queues.push_back(new WorkQueue());
+	}
+
+	running = true;
+
+	for (int i = 1; i <= workerCount; i++)
+	{
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+void JobSystem::shutdown()
+{
+	if (!running)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	sleepCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+	workers.clear();
+
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		delete queues[i];
+	}
+	queues.clear();
+}
+
+void JobSystem::run(const JobFunction& function, JobCounter* counter, JobCounter* dependency)
+{
+	Job job;
+	job.function = function;
+	job.counter = counter;
+
+	if (counter)
+	{
+		counter->count++;
+	}
+
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+
+		//A dependência ainda não terminou: o job é enfileirado por quem zerar o contador
+		if (dependency->count.load() > 0)
+		{
+			dependency->continuations.push_back(job);
+			return;
+		}
+	}
+
+	push(job);
+}
+
+void JobSystem::push(const Job& job)
+{
+	WorkQueue* queue = queues[currentQueue < (int)queues.size() ? currentQueue : 0];
+
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+
+	queuedJobs++;
+
+	//Passa pelo mutex para não perder o aviso de um worker que está indo dormir
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	sleepCondition.notify_one();
+}
+
+bool JobSystem::pop(Job& job)
+{
+	int count = (int)queues.size();
+	int own = currentQueue < count ? currentQueue : 0;
+
+	//Primeiro o fim da própria fila (o job mais recente, com os dados ainda no cache)
+	{
+		WorkQueue* queue = queues[own];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		if (!queue->jobs.empty())
+		{
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	//Depois rouba do início da fila das outras threads (os jobs mais antigos, normalmente maiores)
+	stealSeed = stealSeed * 1103515245u + 12345u;
+
+	for (int i = 0; i < count; i++)
+	{
+		int victim = (int)((stealSeed + i) % count);
+
+		if (victim == own)
+		{
+			continue;
+		}
+
+		WorkQueue* queue = queues[victim];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		if (!queue->jobs.empty())
+		{
+			job = queue->jobs.front();
+			queue->jobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.function();
+
+	JobCounter* counter = job.counter;
+
+	if (counter)
+	{
+		//O decremento é feito com o mutex para que wait() e run() vejam o contador
+		//e as continuações de forma consistente
+		vector <Job> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->mutex);
+			if (--counter->count == 0)
+			{
+				continuations.swap(counter->continuations);
+			}
+		}
+
+		//Libera os jobs que dependiam deste contador
+		for (size_t i = 0; i < continuations.size(); i++)
+		{
+			push(continuations[i]);
+		}
+	}
+}
+
+void JobSystem::wait(JobCounter* counter)
+{
+	//Em vez de bloquear, a thread que espera executa jobs (inclusive os de outras filas)
+	while (!counter->isDone())
+	{
+		Job job;
+
+		if (pop(job))
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	//Garante que quem zerou o contador já o soltou antes que ele possa ser destruído
+	std::lock_guard<std::mutex> lock(counter->mutex);
+}
+
+void JobSystem::parallelFor(int count, int grainSize, const std::function<void(int, int)>& function)
+{
+	grainSize = max(grainSize, 1);
+
+	//Pouco trabalho (ou nenhum worker): roda direto, sem pagar o custo de criar jobs
+	if (count <= grainSize || queues.size() <= 1)
+	{
+		if (count > 0)
+		{
+			function(0, count);
+		}
+		return;
+	}
+
+	JobCounter counter;
+
+	for (int begin = 0; begin < count; begin += grainSize)
+	{
+		int end = min(begin + grainSize, count);
+		run([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+
+	wait(&counter);
+}
+
+void JobSystem::workerLoop(int index)
+{
+	currentQueue = index;
+	stealSeed = index * 2654435761u;
+
+	while (running)
+	{
+		Job job;
+
+		if (pop(job))
+		{
+			execute(job);
+			continue;
+		}
+
+		//Sem trabalho em nenhuma fila: dorme até um push ou o shutdown
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this] { return queuedJobs.load() > 0 || !running; });
+	}
+}
@@ -0,0 +1,313 @@
+#include "light-clusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//Teste esfera x caixa de 4 froxels por vez: SSE em x86, NEON em ARM (Apple Silicon)
+//e um laço escalar nas outras arquiteturas
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define LIGHT_CLUSTERS_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LIGHT_CLUSTERS_NEON 1
+#endif
+
+static const int TILES_PER_SLICE = LightClusters::TILES_X * LightClusters::TILES_Y;
+
+//Bits 0-3: se a esfera toca cada uma das caixas [first, first + 4)
+static inline int testSphere4Scalar(const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ,
+	int first, const glm::vec3& center, float radius)
+{
+	int mask = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		//Distância do centro até a caixa em cada eixo (0 quando o centro está dentro do intervalo)
+		int box = first + i;
+		float dx = std::max(minX[box] - center.x, 0.0f) + std::max(center.x - maxX[box], 0.0f);
+		float dy = std::max(minY[box] - center.y, 0.0f) + std::max(center.y - maxY[box], 0.0f);
+		float dz = std::max(minZ[box] - center.z, 0.0f) + std::max(center.z - maxZ[box], 0.0f);
+		if (dx * dx + dy * dy + dz * dz <= radius * radius)
+		{
+			mask |= 1 << i;
+		}
+	}
+	return mask;
+}
+
+//O mesmo teste com as 4 caixas em um registrador
+static inline int testSphere4(const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ,
+	int first, const glm::vec3& center, float radius)
+{
+#if LIGHT_CLUSTERS_SSE
+	__m128 zero = _mm_setzero_ps();
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+
+	__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + first), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(maxX + first)), zero));
+	__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minY + first), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(maxY + first)), zero));
+	__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minZ + first), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(maxZ + first)), zero));
+	__m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+	return _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_set1_ps(radius * radius)));
+#elif LIGHT_CLUSTERS_NEON
+	float32x4_t zero = vdupq_n_f32(0.0f);
+	float32x4_t cx = vdupq_n_f32(center.x), cy = vdupq_n_f32(center.y), cz = vdupq_n_f32(center.z);
+
+	float32x4_t dx = vaddq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(minX + first), cx), zero), vmaxq_f32(vsubq_f32(cx, vld1q_f32(maxX + first)), zero));
+	float32x4_t dy = vaddq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(minY + first), cy), zero), vmaxq_f32(vsubq_f32(cy, vld1q_f32(maxY + first)), zero));
+	float32x4_t dz = vaddq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(minZ + first), cz), zero), vmaxq_f32(vsubq_f32(cz, vld1q_f32(maxZ + first)), zero));
+	float32x4_t distance2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+
+	//Cada pista do resultado é 0 ou 0xFFFFFFFF; o peso de cada pista monta a máscara
+	static const uint32_t weights[4] = { 1, 2, 4, 8 };
+	uint32x4_t inside = vandq_u32(vcleq_f32(distance2, vdupq_n_f32(radius * radius)), vld1q_u32(weights));
+	uint32x2_t sum = vadd_u32(vget_low_u32(inside), vget_high_u32(inside));
+	return (int)(vget_lane_u32(sum, 0) + vget_lane_u32(sum, 1));
+#else
+	return testSphere4Scalar(minX, minY, minZ, maxX, maxY, maxZ, first, center, radius);
+#endif
+}
+
+void LightClusters::initialize()
+{
+	glGenBuffers(3, buffers);
+	glGenTextures(3, textures);
+
+	GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	for (int i = 0; i < 3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterBlock), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void LightClusters::attach(Shader& shader) const
+{
+	GLuint blockIndex = glGetUniformBlockIndex(shader.ID, "Clusters");
+
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		std::cout << "ERROR::LIGHT_CLUSTERS::BLOCK_NOT_FOUND Clusters" << std::endl;
+		return;
+	}
+
+	glUniformBlockBinding(shader.ID, blockIndex, BINDING);
+
+	//O programa precisa estar em uso (Shader::set* age sobre o programa atual)
+	shader.setInt("clusterLights", LIGHTS_UNIT);
+	shader.setInt("clusterRanges", RANGES_UNIT);
+	shader.setInt("clusterIndices", INDICES_UNIT);
+}
+
+void LightClusters::updateBounds(const Camera& camera)
+{
+	//As caixas só dependem da projeção, não da posição da câmera
+	if (camera.getFovy() == fovy && camera.getAspectRatio() == aspectRatio && camera.getNearPlane() == nearPlane && camera.getFarPlane() == farPlane
+		&& camera.isReverseZ() == infiniteFar)
+	{
+		return;
+	}
+
+	fovy = camera.getFovy();
+	aspectRatio = camera.getAspectRatio();
+	nearPlane = camera.getNearPlane();
+	farPlane = camera.getFarPlane();
+	infiniteFar = camera.isReverseZ();
+
+	//Fatias exponenciais: fatia = log(profundidade) * sliceScale + sliceBias
+	float logRatio = log(farPlane / nearPlane);
+	sliceScale = SLICES / logRatio;
+	sliceBias = -SLICES * log(nearPlane) / logRatio;
+
+	float tanHalfY = tan(glm::radians(fovy) / 2.0f);
+	float tanHalfX = tanHalfY * aspectRatio;
+
+	minX.resize(CLUSTER_COUNT); minY.resize(CLUSTER_COUNT); minZ.resize(CLUSTER_COUNT);
+	maxX.resize(CLUSTER_COUNT); maxY.resize(CLUSTER_COUNT); maxZ.resize(CLUSTER_COUNT);
+
+	for (int slice = 0; slice < SLICES; slice++)
+	{
+		float sliceNear = nearPlane * pow(farPlane / nearPlane, (float)slice / SLICES);
+		float sliceFar = nearPlane * pow(farPlane / nearPlane, (float)(slice + 1) / SLICES);
+
+		//Os fragmentos além de farPlane caem na última fatia (o shader limita a fatia)
+		if (infiniteFar && slice == SLICES - 1)
+		{
+			sliceFar = FLT_MAX;
+		}
+
+		for (int y = 0; y < TILES_Y; y++)
+		{
+			float y0 = -1.0f + 2.0f * y / TILES_Y, y1 = -1.0f + 2.0f * (y + 1) / TILES_Y;
+
+			for (int x = 0; x < TILES_X; x++)
+			{
+				float x0 = -1.0f + 2.0f * x / TILES_X, x1 = -1.0f + 2.0f * (x + 1) / TILES_X;
+				int cluster = (slice * TILES_Y + y) * TILES_X + x;
+
+				//O tile se abre com a profundidade: a caixa envolve os cantos nas duas pontas da fatia
+				minX[cluster] = std::min(std::min(x0 * sliceNear, x0 * sliceFar), std::min(x1 * sliceNear, x1 * sliceFar)) * tanHalfX;
+				maxX[cluster] = std::max(std::max(x0 * sliceNear, x0 * sliceFar), std::max(x1 * sliceNear, x1 * sliceFar)) * tanHalfX;
+				minY[cluster] = std::min(std::min(y0 * sliceNear, y0 * sliceFar), std::min(y1 * sliceNear, y1 * sliceFar)) * tanHalfY;
+				maxY[cluster] = std::max(std::max(y0 * sliceNear, y0 * sliceFar), std::max(y1 * sliceNear, y1 * sliceFar)) * tanHalfY;
+				minZ[cluster] = sliceNear;
+				maxZ[cluster] = sliceFar;
+			}
+		}
+	}
+}
+
+void LightClusters::build(const Camera& camera, const vector <PointLight>& lights, bool useSimd)
+{
+	updateBounds(camera);
+
+	lightCount = (int)lights.size();
+	lightData.resize(2 * lights.size());
+	pairClusters.clear();
+	pairLights.clear();
+
+	const glm::mat4& view = camera.getViewMatrix();
+
+	for (int i = 0; i < lightCount; i++)
+	{
+		const PointLight& light = lights[i];
+		lightData[2 * i] = glm::vec4(light.position, light.radius);
+		lightData[2 * i + 1] = glm::vec4(light.color, 0.0f);
+
+		//No espaço da view a câmera olha para -z; as caixas usam a profundidade positiva
+		glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		center.z = -center.z;
+		binLight(i, center, light.radius, useSimd);
+	}
+
+	//Ordenação por contagem: primeiro o número de luzes de cada froxel, depois o início de cada lista
+	ranges.assign(2 * CLUSTER_COUNT, 0);
+	for (size_t pair = 0; pair < pairClusters.size(); pair++)
+	{
+		ranges[2 * pairClusters[pair] + 1]++;
+	}
+
+	unsigned int offset = 0;
+	maxClusterLights = 0;
+	for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		ranges[2 * cluster] = offset;
+		offset += ranges[2 * cluster + 1];
+		maxClusterLights = std::max(maxClusterLights, (int)ranges[2 * cluster + 1]);
+	}
+
+	indices.resize(pairClusters.size());
+	vector <unsigned int> cursor(CLUSTER_COUNT);
+	for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		cursor[cluster] = ranges[2 * cluster];
+	}
+
+	for (size_t pair = 0; pair < pairClusters.size(); pair++)
+	{
+		indices[cursor[pairClusters[pair]]++] = pairLights[pair];
+	}
+}
+
+void LightClusters::binLight(int light, const glm::vec3& center, float radius, bool useSimd)
+{
+	//Fora do intervalo de profundidade dos froxels
+	if (center.z + radius < nearPlane || (!infiniteFar && center.z - radius > farPlane))
+	{
+		return;
+	}
+
+	//Só as fatias que a esfera alcança em z são testadas
+	int firstSlice = (int)floor(log(std::max(center.z - radius, nearPlane)) * sliceScale + sliceBias);
+	int lastSlice = (int)floor(log(std::min(center.z + radius, farPlane)) * sliceScale + sliceBias);
+	firstSlice = std::min(std::max(firstSlice, 0), SLICES - 1);
+	lastSlice = std::min(lastSlice, SLICES - 1);
+
+	const float* boxes[6] = { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+
+	for (int slice = firstSlice; slice <= lastSlice; slice++)
+	{
+		int first = slice * TILES_PER_SLICE;
+
+		for (int cluster = first; cluster < first + TILES_PER_SLICE; cluster += 4)
+		{
+			int mask = useSimd ? testSphere4(boxes[0], boxes[1], boxes[2], boxes[3], boxes[4], boxes[5], cluster, center, radius)
+				: testSphere4Scalar(boxes[0], boxes[1], boxes[2], boxes[3], boxes[4], boxes[5], cluster, center, radius);
+
+			for (int i = 0; mask; i++, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					pairClusters.push_back(cluster + i);
+					pairLights.push_back(light);
+				}
+			}
+		}
+	}
+}
+
+void LightClusters::upload(glm::vec4 viewport)
+{
+	ClusterBlock block;
+	block.grid = glm::vec4(TILES_X, TILES_Y, SLICES, lightCount);
+	block.depth = glm::vec4(sliceScale, sliceBias, nearPlane, farPlane);
+	block.viewport = glm::vec4(viewport.x, viewport.y, viewport.z / TILES_X, viewport.w / TILES_Y);
+
+	const void* data[3] = { lightData.data(), ranges.data(), indices.data() };
+	size_t sizes[3] = { lightData.size() * sizeof(glm::vec4), ranges.size() * sizeof(unsigned int), indices.size() * sizeof(unsigned int) };
+
+	GL_STATS_ADD(STAT_BUFFER_UPLOADS, 4);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, sizes[0] + sizes[1] + sizes[2] + sizeof(ClusterBlock));
+
+	//glBufferData descarta o conteúdo anterior sem esperar os draws do frame passado
+	for (int i = 0; i < 3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, std::max(sizes[i], (size_t)16), NULL, GL_STREAM_DRAW);
+		if (sizes[i] > 0)
+		{
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, sizes[i], data[i]);
+		}
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ClusterBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void LightClusters::bind() const
+{
+	GL_STATS_ADD(STAT_TEXTURE_BINDS, 3);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+
+	int units[3] = { LIGHTS_UNIT, RANGES_UNIT, INDICES_UNIT };
+	for (int i = 0; i < 3; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::release()
+{
+	if (UBO)
+	{
+		glDeleteTextures(3, textures);
+		glDeleteBuffers(3, buffers);
+		glDeleteBuffers(1, &UBO);
+		UBO = 0;
+	}
+}
@@ -0,0 +1,438 @@
+#include "mesh-simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+
+//Cosseno mínimo entre a normal de um triângulo antes e depois do colapso
+static const double MIN_NORMAL_COSINE = 0.2;
+
+void MeshSimplifier::initialize(const vector <float>& vertices)
+{
+	attributes.clear();
+	wedgePosition.clear();
+	positions.clear();
+	triangles.clear();
+	maxError = 0.0f;
+
+	//Vértices com todos os atributos iguais viram um wedge, e wedges na mesma posição
+	//compartilham a posição (as comparações são exatas, como os valores do OBJ)
+	map <array <float, VERTEX_FLOATS>, int> wedgeIds;
+	map <array <float, 3>, int> positionIds;
+	int vertexCount = (int)vertices.size() / VERTEX_FLOATS;
+
+	for (int i = 0; i < vertexCount; i++)
+	{
+		array <float, VERTEX_FLOATS> key;
+		std::copy(vertices.begin() + i * VERTEX_FLOATS, vertices.begin() + (i + 1) * VERTEX_FLOATS, key.begin());
+
+		map <array <float, VERTEX_FLOATS>, int>::iterator wedge = wedgeIds.find(key);
+		if (wedge == wedgeIds.end())
+		{
+			array <float, 3> positionKey = { { key[0], key[1], key[2] } };
+			map <array <float, 3>, int>::iterator position = positionIds.find(positionKey);
+			if (position == positionIds.end())
+			{
+				position = positionIds.insert(make_pair(positionKey, (int)positions.size())).first;
+				positions.push_back(glm::dvec3(key[0], key[1], key[2]));
+			}
+
+			wedge = wedgeIds.insert(make_pair(key, (int)wedgePosition.size())).first;
+			wedgePosition.push_back(position->second);
+			attributes.insert(attributes.end(), key.begin(), key.end());
+		}
+		triangles.push_back(wedge->second);
+	}
+
+	//Triângulos com dois cantos na mesma posição não têm área nem plano
+	int triangleCount = vertexCount / 3;
+	alive.assign(triangleCount, 1);
+	liveTriangles = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int p0 = wedgePosition[triangles[t * 3]], p1 = wedgePosition[triangles[t * 3 + 1]], p2 = wedgePosition[triangles[t * 3 + 2]];
+		if (p0 == p1 || p1 == p2 || p2 == p0)
+		{
+			alive[t] = 0;
+			continue;
+		}
+		liveTriangles++;
+	}
+
+	//Posições com mais de um wedge estão em uma costura
+	int positionCount = (int)positions.size();
+	locked.assign(positionCount, 0);
+	positionWedge.assign(positionCount, -1);
+	for (int w = 0; w < (int)wedgePosition.size(); w++)
+	{
+		int position = wedgePosition[w];
+		if (positionWedge[position] >= 0)
+		{
+			locked[position] = 1;
+		}
+		positionWedge[position] = w;
+	}
+
+	//Arestas que não têm exatamente dois triângulos estão em uma borda (ou não são manifold)
+	vector <pair <int, int> > edges;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		if (!alive[t])
+		{
+			continue;
+		}
+		for (int corner = 0; corner < 3; corner++)
+		{
+			int a = wedgePosition[triangles[t * 3 + corner]];
+			int b = wedgePosition[triangles[t * 3 + (corner + 1) % 3]];
+			edges.push_back(make_pair(std::min(a, b), std::max(a, b)));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t j = i;
+		while (j < edges.size() && edges[j] == edges[i])
+		{
+			j++;
+		}
+		if (j - i != 2)
+		{
+			locked[edges[i].first] = 1;
+			locked[edges[i].second] = 1;
+		}
+		i = j;
+	}
+
+	//Quádrica de cada posição: a soma dos planos dos seus triângulos
+	Quadric zero;
+	std::fill(zero.a, zero.a + 10, 0.0);
+	quadrics.assign(positionCount, zero);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		if (!alive[t])
+		{
+			continue;
+		}
+		int corners[3] = { wedgePosition[triangles[t * 3]], wedgePosition[triangles[t * 3 + 1]], wedgePosition[triangles[t * 3 + 2]] };
+		glm::dvec3 normal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+		double length = glm::length(normal);
+		if (length <= 0.0)
+		{
+			continue;
+		}
+		normal /= length;
+		double distance = -glm::dot(normal, positions[corners[0]]);
+		for (int corner = 0; corner < 3; corner++)
+		{
+			addPlane(quadrics[corners[corner]], normal, distance);
+		}
+	}
+}
+
+int MeshSimplifier::simplify(int targetTriangles)
+{
+	//Cada passada ordena as arestas pelo custo e aplica as mais baratas; as duas
+	//posições de um colapso não participam de outro na mesma passada, porque o custo
+	//e a vizinhança delas mudaram
+	while (liveTriangles > targetTriangles)
+	{
+		buildAdjacency();
+
+		vector <pair <int, int> > edges;
+		for (int t = 0; t < (int)alive.size(); t++)
+		{
+			if (!alive[t])
+			{
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++)
+			{
+				int a = wedgePosition[triangles[t * 3 + corner]];
+				int b = wedgePosition[triangles[t * 3 + (corner + 1) % 3]];
+				edges.push_back(make_pair(std::min(a, b), std::max(a, b)));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		vector <Collapse> collapses;
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			int a = edges[i].first, b = edges[i].second;
+			if (locked[a] && locked[b])
+			{
+				continue;
+			}
+
+			Quadric sum = quadrics[a];
+			addQuadric(sum, quadrics[b]);
+
+			//A posição que some é a não travada; se as duas podem sumir, fica a mais barata
+			Collapse collapse;
+			if (locked[a])
+			{
+				collapse.from = b;
+				collapse.to = a;
+				collapse.cost = evaluate(sum, positions[a]);
+			}
+			else if (locked[b])
+			{
+				collapse.from = a;
+				collapse.to = b;
+				collapse.cost = evaluate(sum, positions[b]);
+			}
+			else
+			{
+				double costA = evaluate(sum, positions[a]), costB = evaluate(sum, positions[b]);
+				collapse.from = costA < costB ? b : a;
+				collapse.to = costA < costB ? a : b;
+				collapse.cost = std::min(costA, costB);
+			}
+			collapses.push_back(collapse);
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		vector <char> touched(positions.size(), 0);
+		int applied = 0;
+		for (size_t i = 0; i < collapses.size() && liveTriangles > targetTriangles; i++)
+		{
+			const Collapse& collapse = collapses[i];
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			int toWedge;
+			if (!isValidCollapse(collapse.from, collapse.to, toWedge))
+			{
+				continue;
+			}
+
+			applyCollapse(collapse.from, collapse.to, toWedge);
+			touched[collapse.from] = 1;
+			touched[collapse.to] = 1;
+			maxError = std::max(maxError, (float)sqrt(std::max(collapse.cost, 0.0)));
+			applied++;
+		}
+
+		//Todas as arestas que sobraram estão travadas ou dobrariam a malha
+		if (applied == 0)
+		{
+			break;
+		}
+	}
+
+	return liveTriangles;
+}
+
+vector <float> MeshSimplifier::getVertices() const
+{
+	vector <float> vertices;
+	vertices.reserve(liveTriangles * 3 * VERTEX_FLOATS);
+
+	for (int t = 0; t < (int)alive.size(); t++)
+	{
+		if (!alive[t])
+		{
+			continue;
+		}
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* wedge = &attributes[triangles[t * 3 + corner] * VERTEX_FLOATS];
+			vertices.insert(vertices.end(), wedge, wedge + VERTEX_FLOATS);
+		}
+	}
+	return vertices;
+}
+
+int MeshSimplifier::getLockedCount() const
+{
+	return (int)std::count(locked.begin(), locked.end(), 1);
+}
+
+void MeshSimplifier::addPlane(Quadric& quadric, const glm::dvec3& normal, double distance)
+{
+	//Plano (a, b, c, d): a quádrica é o produto externo do plano com ele mesmo
+	double plane[4] = { normal.x, normal.y, normal.z, distance };
+	int k = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = i; j < 4; j++)
+		{
+			quadric.a[k++] += plane[i] * plane[j];
+		}
+	}
+}
+
+void MeshSimplifier::addQuadric(Quadric& target, const Quadric& source)
+{
+	for (int i = 0; i < 10; i++)
+	{
+		target.a[i] += source.a[i];
+	}
+}
+
+double MeshSimplifier::evaluate(const Quadric& quadric, const glm::dvec3& point)
+{
+	//v^T Q v com v = (x, y, z, 1); os termos fora da diagonal aparecem duas vezes
+	const double* q = quadric.a;
+	double x = point.x, y = point.y, z = point.z;
+	return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+		+ q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+		+ q[7] * z * z + 2.0 * q[8] * z
+		+ q[9];
+}
+
+void MeshSimplifier::buildAdjacency()
+{
+	int positionCount = (int)positions.size();
+	adjacencyOffsets.assign(positionCount + 1, 0);
+
+	for (int t = 0; t < (int)alive.size(); t++)
+	{
+		if (alive[t])
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				adjacencyOffsets[wedgePosition[triangles[t * 3 + corner]] + 1]++;
+			}
+		}
+	}
+	for (int p = 0; p < positionCount; p++)
+	{
+		adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+	}
+
+	adjacency.resize(adjacencyOffsets[positionCount]);
+	vector <int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (int t = 0; t < (int)alive.size(); t++)
+	{
+		if (alive[t])
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				adjacency[fill[wedgePosition[triangles[t * 3 + corner]]]++] = t;
+			}
+		}
+	}
+}
+
+bool MeshSimplifier::isValidCollapse(int from, int to, int& toWedge) const
+{
+	toWedge = -1;
+	int shared = 0;
+	vector <int> fromNeighbours;
+
+	for (int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+	{
+		int t = adjacency[i];
+		if (!alive[t])
+		{
+			continue;
+		}
+
+		int corners[3] = { wedgePosition[triangles[t * 3]], wedgePosition[triangles[t * 3 + 1]], wedgePosition[triangles[t * 3 + 2]] };
+		int fromCorner = corners[0] == from ? 0 : (corners[1] == from ? 1 : 2);
+		int toCorner = corners[0] == to ? 0 : (corners[1] == to ? 1 : (corners[2] == to ? 2 : -1));
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (corner != fromCorner && std::find(fromNeighbours.begin(), fromNeighbours.end(), corners[corner]) == fromNeighbours.end())
+			{
+				fromNeighbours.push_back(corners[corner]);
+			}
+		}
+
+		//Os triângulos da aresta somem; os dois precisam ter o mesmo wedge em `to`,
+		//que passa a ser o wedge de todos os triângulos de `from`
+		if (toCorner >= 0)
+		{
+			int wedge = triangles[t * 3 + toCorner];
+			if (toWedge >= 0 && wedge != toWedge)
+			{
+				return false;
+			}
+			toWedge = wedge;
+			shared++;
+			continue;
+		}
+
+		//Os outros não podem virar do avesso (nem ficar sem área)
+		glm::dvec3 p0 = positions[corners[0]], p1 = positions[corners[1]], p2 = positions[corners[2]];
+		glm::dvec3 before = glm::cross(p1 - p0, p2 - p0);
+		(fromCorner == 0 ? p0 : (fromCorner == 1 ? p1 : p2)) = positions[to];
+		glm::dvec3 after = glm::cross(p1 - p0, p2 - p0);
+
+		double beforeLength = glm::length(before), afterLength = glm::length(after);
+		if (afterLength <= 0.0 || glm::dot(before, after) < MIN_NORMAL_COSINE * beforeLength * afterLength)
+		{
+			return false;
+		}
+	}
+
+	if (shared != 2)
+	{
+		return false;
+	}
+
+	//Condição de link: os dois só podem ter em comum os vizinhos dos triângulos da
+	//aresta, senão o colapso junta duas faces e a malha deixa de ser manifold
+	int common = 0;
+	vector <int> toNeighbours;
+	for (int i = adjacencyOffsets[to]; i < adjacencyOffsets[to + 1]; i++)
+	{
+		int t = adjacency[i];
+		if (!alive[t])
+		{
+			continue;
+		}
+		for (int corner = 0; corner < 3; corner++)
+		{
+			int position = wedgePosition[triangles[t * 3 + corner]];
+			if (position != to && position != from && std::find(toNeighbours.begin(), toNeighbours.end(), position) == toNeighbours.end())
+			{
+				toNeighbours.push_back(position);
+				if (std::find(fromNeighbours.begin(), fromNeighbours.end(), position) != fromNeighbours.end())
+				{
+					common++;
+				}
+			}
+		}
+	}
+
+	return common == 2;
+}
+
+void MeshSimplifier::applyCollapse(int from, int to, int toWedge)
+{
+	for (int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+	{
+		int t = adjacency[i];
+		if (!alive[t])
+		{
+			continue;
+		}
+
+		unsigned int* corners = &triangles[t * 3];
+		bool hasTo = wedgePosition[corners[0]] == to || wedgePosition[corners[1]] == to || wedgePosition[corners[2]] == to;
+		if (hasTo)
+		{
+			alive[t] = 0;
+			liveTriangles--;
+			continue;
+		}
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (wedgePosition[corners[corner]] == from)
+			{
+				corners[corner] = toWedge;
+			}
+		}
+	}
+
+	addQuadric(quadrics[to], quadrics[from]);
+}
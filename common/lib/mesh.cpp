@@ -1,5 +1,9 @@
 #include "mesh.h"
 
+//Fração do limite que o tamanho na tela precisa passar para trocar de nível,
+//para o nível não ficar alternando quando o objeto está perto do limite
+static const float LOD_HYSTERESIS = 0.1f;
+
 void Mesh::initialize(GLuint VAO, int nVertices, Shader* shader, GLuint textureID, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
 {
 	this->VAO = VAO;
@@ -11,6 +15,47 @@ void Mesh::initialize(GLuint VAO, int nVertices, Shader* shader, GLuint textureI
 	this->axis = axis;
 	this->textureID = textureID;
 	this->shouldRotateY = false;
+	this->model = glm::mat4(1);
+
+	MeshLod base = { VAO, nVertices, 0.0f };
+	lods.assign(1, base);
+	lod = 0;
+	for (int i = 0; i < MAX_LOD_VIEWS; i++)
+	{
+		viewLods[i] = 0;
+	}
+}
+
+void Mesh::addLod(GLuint VAO, int nVertices, float maxScreenSize)
+{
+	MeshLod level = { VAO, nVertices, maxScreenSize };
+	lods.push_back(level);
+}
+
+int Mesh::selectLod(float screenSize, int view)
+{
+	//Parte do nível que a view usou no frame anterior: só fica mais simples quando o
+	//tamanho já está a LOD_HYSTERESIS abaixo do limite do próximo nível, e só volta a
+	//ficar mais detalhado quando está a LOD_HYSTERESIS acima do limite do atual
+	int& current = viewLods[view];
+	while (current + 1 < (int)lods.size() && screenSize < lods[current + 1].maxScreenSize * (1.0f - LOD_HYSTERESIS))
+	{
+		current++;
+	}
+	while (current > 0 && screenSize > lods[current].maxScreenSize * (1.0f + LOD_HYSTERESIS))
+	{
+		current--;
+	}
+
+	setLod(current);
+	return current;
+}
+
+void Mesh::setLod(int lod)
+{
+	this->lod = lod;
+	VAO = lods[lod].VAO;
+	nVertices = lods[lod].nVertices;
 }
 
 void Mesh::updatePosition(glm::vec3 position) {
@@ -21,33 +66,92 @@ void Mesh::setShouldRotateY(bool shouldRotateY) {
 	this->shouldRotateY = shouldRotateY;
 }
 
-void Mesh::update()
+void Mesh::setRotationSpeed(float rotationSpeed) {
+	this->rotationSpeed = rotationSpeed;
+}
+
+void Mesh::update(float deltaTime)
 {
-	glm::mat4 model = glm::mat4(1);
+	model = glm::mat4(1);
 	model = glm::translate(model, position);
 	
 	if(shouldRotateY) {
-		this->angle += 0.001;
+		this->angle += rotationSpeed * deltaTime;
 		model = glm::rotate(model, this->angle, glm::vec3(0.0, 1.0, 0.0));
 	} else {
 		model = glm::rotate(model, angle, axis);
 	}
 		
 	model = glm::scale(model, scale);
-	shader->setMat4("model", glm::value_ptr(model));
 }
 
 void Mesh::draw(Material material)
 {
+	draw(material, model);
+}
+
+void Mesh::draw(Material material, const glm::mat4& model)
+{
+	//A matriz model é enviada no draw para que a mesma malha possa ser desenhada em várias views
+	//(e vir de um snapshot calculado em outra thread)
+	glm::mat4 modelMatrix = model;
+	shader->setMat4("model", glm::value_ptr(modelMatrix));
 	shader->setVec3("ka", material.ambient.r, material.ambient.g, material.ambient.b);
   shader->setVec3("kd", material.diffuse.r, material.diffuse.g, material.diffuse.b);
   shader->setVec3("ks", material.specular.r, material.specular.g, material.specular.b);
   shader->setFloat("q", material.shininess);
 
+	GL_STATS_COUNT(STAT_TEXTURE_BINDS);
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+	GL_STATS_COUNT(STAT_DRAW_CALLS);
+	GL_STATS_ADD(STAT_VERTICES, nVertices);
+
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, textureID);
 	glBindVertexArray(VAO);
 	glDrawArrays(GL_TRIANGLES, 0, nVertices);
 	glBindVertexArray(0);
 	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Mesh::drawInstances(Material material, int instanceCount)
+{
+	setMaterialUniforms(material);
+	bindTexture();
+	bindVertexArray();
+	drawBoundInstances(instanceCount);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Mesh::setMaterialUniforms(const Material& material) const
+{
+	shader->setVec3("ka", material.ambient.r, material.ambient.g, material.ambient.b);
+	shader->setVec3("kd", material.diffuse.r, material.diffuse.g, material.diffuse.b);
+	shader->setVec3("ks", material.specular.r, material.specular.g, material.specular.b);
+	shader->setFloat("q", material.shininess);
+}
+
+void Mesh::bindTexture() const
+{
+	GL_STATS_COUNT(STAT_TEXTURE_BINDS);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+}
+
+void Mesh::bindVertexArray() const
+{
+	GL_STATS_COUNT(STAT_VERTEX_ARRAY_BINDS);
+
+	glBindVertexArray(VAO);
+}
+
+void Mesh::drawBoundInstances(int instanceCount) const
+{
+	//As matrizes model vêm do atributo por instância ligado ao VAO (InstanceBuffer::attach)
+	GL_STATS_COUNT(STAT_DRAW_CALLS);
+	GL_STATS_ADD(STAT_VERTICES, nVertices * instanceCount);
+
+	glDrawArraysInstanced(GL_TRIANGLES, 0, nVertices, instanceCount);
 }
\ No newline at end of file
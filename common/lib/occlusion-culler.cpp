@@ -0,0 +1,184 @@
+#include "occlusion-culler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//Distância mínima da câmera (w) para um vértice ser projetado; abaixo disso o
+//triângulo ou a esfera cruza o plano da câmera
+static const float MIN_W = 1e-3f;
+//Triângulos com área menor que isso (em pixels) não cobrem nenhum centro de pixel
+static const float MIN_AREA = 1e-6f;
+static const float SQRT3 = 1.7320508f;
+
+static float edge(const glm::vec3& a, const glm::vec3& b, float x, float y)
+{
+	return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+OcclusionCuller::OcclusionCuller() : viewProjection(1.0f), occluderTriangles(0)
+{
+	//Até o nível de 1 texel de altura
+	for (int width = WIDTH, height = HEIGHT; width > 0 && height > 0; width /= 2, height /= 2)
+	{
+		levels.push_back(vector <float>(width * height, FLT_MAX));
+	}
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection)
+{
+	this->viewProjection = viewProjection;
+	occluderTriangles = 0;
+	std::fill(levels[0].begin(), levels[0].end(), FLT_MAX);
+}
+
+void OcclusionCuller::addOccluder(const vector <float>& vertices, const glm::mat4& model, int vertexFloats)
+{
+	glm::mat4 modelViewProjection = viewProjection * model;
+	int triangleCount = (int)vertices.size() / (3 * vertexFloats);
+
+	for (int t = 0; t < triangleCount; t++)
+	{
+		glm::vec4 clip[3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* position = &vertices[(t * 3 + corner) * vertexFloats];
+			clip[corner] = modelViewProjection * glm::vec4(position[0], position[1], position[2], 1.0f);
+		}
+		rasterizeTriangle(clip[0], clip[1], clip[2]);
+	}
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	if (a.w <= MIN_W || b.w <= MIN_W || c.w <= MIN_W)
+	{
+		return;
+	}
+
+	//Posição em pixels e 1 / w, que varia linearmente na tela
+	const glm::vec4* clip[3] = { &a, &b, &c };
+	glm::vec3 screen[3];
+	for (int i = 0; i < 3; i++)
+	{
+		float inverseW = 1.0f / clip[i]->w;
+		screen[i] = glm::vec3((clip[i]->x * inverseW * 0.5f + 0.5f) * WIDTH, (clip[i]->y * inverseW * 0.5f + 0.5f) * HEIGHT, inverseW);
+	}
+
+	//Os dois sentidos de rotação são aceitos: o sinal da área normaliza os pesos
+	float area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+	if (fabs(area) < MIN_AREA)
+	{
+		return;
+	}
+	float inverseArea = 1.0f / area;
+
+	int minX = std::max(0, (int)floor(std::min(screen[0].x, std::min(screen[1].x, screen[2].x))));
+	int maxX = std::min(WIDTH - 1, (int)ceil(std::max(screen[0].x, std::max(screen[1].x, screen[2].x))));
+	int minY = std::max(0, (int)floor(std::min(screen[0].y, std::min(screen[1].y, screen[2].y))));
+	int maxY = std::min(HEIGHT - 1, (int)ceil(std::max(screen[0].y, std::max(screen[1].y, screen[2].y))));
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	occluderTriangles++;
+	vector <float>& depth = levels[0];
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		float centerY = y + 0.5f;
+		for (int x = minX; x <= maxX; x++)
+		{
+			//Pesos baricêntricos do centro do pixel
+			float centerX = x + 0.5f;
+			float w0 = edge(screen[1], screen[2], centerX, centerY) * inverseArea;
+			float w1 = edge(screen[2], screen[0], centerX, centerY) * inverseArea;
+			float w2 = 1.0f - w0 - w1;
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+			{
+				continue;
+			}
+
+			float distance = 1.0f / (w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z);
+			float& pixel = depth[y * WIDTH + x];
+			pixel = std::min(pixel, distance);
+		}
+	}
+}
+
+void OcclusionCuller::buildPyramid()
+{
+	for (size_t level = 1; level < levels.size(); level++)
+	{
+		const vector <float>& source = levels[level - 1];
+		vector <float>& target = levels[level];
+		int sourceWidth = WIDTH >> (level - 1);
+		int width = WIDTH >> level, height = HEIGHT >> level;
+
+		//Cada texel guarda o oclusor mais distante do bloco 2x2 abaixo dele
+		for (int y = 0; y < height; y++)
+		{
+			const float* row0 = &source[(y * 2) * sourceWidth];
+			const float* row1 = row0 + sourceWidth;
+			for (int x = 0; x < width; x++)
+			{
+				target[y * width + x] = std::max(std::max(row0[x * 2], row0[x * 2 + 1]), std::max(row1[x * 2], row1[x * 2 + 1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::isSphereOccluded(const glm::vec3& center, float radius) const
+{
+	//A vista é rígida, então w é a distância ao longo da direção da câmera e a frente
+	//da esfera está a w - radius. Os cantos da caixa da esfera estão a até radius * sqrt(3)
+	glm::vec4 clipCenter = viewProjection * glm::vec4(center, 1.0f);
+	float nearest = clipCenter.w - radius;
+	if (clipCenter.w - radius * SQRT3 <= MIN_W)
+	{
+		return false;
+	}
+
+	//Retângulo na tela da caixa da esfera
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 offset(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+		glm::vec4 clip = viewProjection * glm::vec4(center + offset, 1.0f);
+		float x = (clip.x / clip.w * 0.5f + 0.5f) * WIDTH, y = (clip.y / clip.w * 0.5f + 0.5f) * HEIGHT;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+	}
+
+	//Só a parte dentro da tela pode ser vista; o resto fica para o frustum culling
+	int x0 = std::max(0, (int)floor(minX)), x1 = std::min(WIDTH - 1, (int)floor(maxX));
+	int y0 = std::max(0, (int)floor(minY)), y1 = std::min(HEIGHT - 1, (int)floor(maxY));
+	if (x0 > x1 || y0 > y1)
+	{
+		return false;
+	}
+
+	//O primeiro nível em que o retângulo cobre no máximo 2x2 texels
+	int level = 0;
+	while (level + 1 < (int)levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+	{
+		level++;
+	}
+
+	const vector <float>& depth = levels[level];
+	int width = WIDTH >> level;
+	for (int y = y0 >> level; y <= y1 >> level; y++)
+	{
+		for (int x = x0 >> level; x <= x1 >> level; x++)
+		{
+			if (depth[y * width + x] >= nearest)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,281 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//Peso do frame atual nas médias móveis exibidas no overlay
+static const float STAT_SMOOTHING = 0.1f;
+//Limite de eventos guardados para exportação, para uma gravação esquecida não consumir toda a memória
+static const size_t MAX_TRACE_EVENTS = 1000000;
+
+Profiler::Profiler()
+	: origin(std::chrono::steady_clock::now()), gpuTimers(false), recording(false), frame(0), gpuScopeOpen(false)
+{
+}
+
+void Profiler::initialize(bool gpuTimers)
+{
+	this->gpuTimers = gpuTimers;
+	origin = std::chrono::steady_clock::now();
+	frame = 0;
+}
+
+double Profiler::now() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+ProfileStat& Profiler::getStat(const char* name)
+{
+	map <string, int>::iterator it = statIndices.find(name);
+
+	if (it == statIndices.end())
+	{
+		ProfileStat stat;
+		stat.name = name;
+		stat.cpuMilliseconds = 0.0f;
+		stat.gpuMilliseconds = 0.0f;
+		it = statIndices.insert(make_pair(stat.name, (int)stats.size())).first;
+		stats.push_back(stat);
+	}
+
+	return stats[it->second];
+}
+
+void Profiler::beginFrame()
+{
+	//Os resultados das queries deste slot foram emitidos QUERY_LATENCY frames atrás
+	if (gpuTimers)
+	{
+		collectGPUQueries(frame % QUERY_LATENCY);
+	}
+
+	beginCPU("frame");
+}
+
+void Profiler::endFrame()
+{
+	endCPU();
+	frame++;
+}
+
+void Profiler::beginCPU(const char* name)
+{
+	ProfileEvent event;
+	event.name = name;
+	event.start = now();
+	event.duration = 0.0;
+	event.depth = cpuStack.size();
+	event.gpu = false;
+	cpuStack.push_back(event);
+}
+
+void Profiler::endCPU()
+{
+	if (cpuStack.empty())
+	{
+		return;
+	}
+
+	ProfileEvent event = cpuStack.back();
+	cpuStack.pop_back();
+	event.duration = now() - event.start;
+
+	ProfileStat& stat = getStat(event.name);
+	stat.cpuMilliseconds += (event.duration / 1000.0 - stat.cpuMilliseconds) * STAT_SMOOTHING;
+
+	if (recording && trace.size() < MAX_TRACE_EVENTS)
+	{
+		trace.push_back(event);
+	}
+}
+
+void Profiler::beginGPU(const char* name)
+{
+	if (!gpuTimers)
+	{
+		return;
+	}
+
+	if (gpuScopeOpen)
+	{
+		std::cout << "ERROR::PROFILER::NESTED_GPU_SCOPE " << name << std::endl;
+		return;
+	}
+
+	if (freeQueries.empty())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		freeQueries.push_back(query);
+	}
+
+	activeQuery.query = freeQueries.back();
+	activeQuery.name = name;
+	activeQuery.start = now();
+	freeQueries.pop_back();
+	gpuScopeOpen = true;
+
+	glBeginQuery(GL_TIME_ELAPSED, activeQuery.query);
+}
+
+void Profiler::endGPU()
+{
+	if (!gpuScopeOpen)
+	{
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	pendingQueries[frame % QUERY_LATENCY].push_back(activeQuery);
+	gpuScopeOpen = false;
+}
+
+void Profiler::collectGPUQueries(int slot)
+{
+	vector <PendingQuery>& queries = pendingQueries[slot];
+
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[i].query, GL_QUERY_RESULT, &elapsed);
+		freeQueries.push_back(queries[i].query);
+
+		double duration = elapsed / 1000.0;
+		ProfileStat& stat = getStat(queries[i].name);
+		stat.gpuMilliseconds += (duration / 1000.0 - stat.gpuMilliseconds) * STAT_SMOOTHING;
+
+		//GL_TIME_ELAPSED só mede a duração, o evento é posicionado no instante em que foi emitido na CPU
+		if (recording && trace.size() < MAX_TRACE_EVENTS)
+		{
+			ProfileEvent event;
+			event.name = queries[i].name;
+			event.start = queries[i].start;
+			event.duration = duration;
+			event.depth = 0;
+			event.gpu = true;
+			trace.push_back(event);
+		}
+	}
+
+	queries.clear();
+}
+
+bool Profiler::saveChromeTrace(const string& path)
+{
+	//Lê as queries que ainda estão em andamento para que os últimos frames também sejam exportados
+	for (int slot = 0; slot < QUERY_LATENCY; slot++)
+	{
+		collectGPUQueries(slot);
+	}
+
+	ofstream file(path.c_str());
+
+	if (!file.is_open())
+	{
+		std::cout << "Failed to open file: " << path << std::endl;
+		return false;
+	}
+
+	file << "{\"traceEvents\":[" << std::endl;
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}}," << std::endl;
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	char line[256];
+
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		const ProfileEvent& event = trace[i];
+		snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.name, event.gpu ? 2 : 1, event.start, event.duration);
+		file << line;
+	}
+
+	file << std::endl << "]}" << std::endl;
+	return file.good();
+}
+
+void Profiler::drawOverlay(int width, int height, float budgetMilliseconds) const
+{
+	//As barras são desenhadas só com glScissor + glClear, sem shader nem geometria.
+	//Cada escopo ocupa uma linha: barra de CPU em cima, barra de GPU embaixo,
+	//com largura proporcional ao orçamento de um frame (metade da tela).
+	const int rowHeight = 12;
+	const int barHeight = 4;
+	const int margin = 10;
+	const float maxBarWidth = width * 0.5f;
+
+	glEnable(GL_SCISSOR_TEST);
+
+	glScissor(margin - 4, height - margin - (int)stats.size() * rowHeight - 4, (int)maxBarWidth + 8, (int)stats.size() * rowHeight + 8);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		int y = height - margin - (int)(i + 1) * rowHeight;
+		int cpuWidth = (int)min(stats[i].cpuMilliseconds / budgetMilliseconds * maxBarWidth, maxBarWidth);
+		int gpuWidth = (int)min(stats[i].gpuMilliseconds / budgetMilliseconds * maxBarWidth, maxBarWidth);
+
+		//Cores diferentes por escopo, variando o matiz com o índice
+		float r = 0.5f + 0.5f * ((i * 37) % 11) / 10.0f;
+		float g = 0.5f + 0.5f * ((i * 53) % 7) / 6.0f;
+		float b = 0.5f + 0.5f * ((i * 71) % 5) / 4.0f;
+
+		if (cpuWidth > 0)
+		{
+			glScissor(margin, y + barHeight + 1, cpuWidth, barHeight);
+			glClearColor(r, g, b, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+
+		if (gpuWidth > 0)
+		{
+			glScissor(margin, y, gpuWidth, barHeight);
+			glClearColor(r * 0.6f, g * 0.6f, b * 0.6f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+}
+
+string Profiler::getSummary() const
+{
+	ostringstream summary;
+	summary.setf(ios::fixed);
+	summary.precision(2);
+
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		summary << (i ? " | " : "") << stats[i].name << " " << stats[i].cpuMilliseconds;
+
+		if (stats[i].gpuMilliseconds > 0.0f)
+		{
+			summary << "/" << stats[i].gpuMilliseconds;
+		}
+	}
+
+	summary << " ms";
+	return summary.str();
+}
+
+void Profiler::release()
+{
+	for (int slot = 0; slot < QUERY_LATENCY; slot++)
+	{
+		for (size_t i = 0; i < pendingQueries[slot].size(); i++)
+		{
+			freeQueries.push_back(pendingQueries[slot][i].query);
+		}
+		pendingQueries[slot].clear();
+	}
+
+	if (!freeQueries.empty())
+	{
+		glDeleteQueries(freeQueries.size(), freeQueries.data());
+		freeQueries.clear();
+	}
+}
@@ -0,0 +1,223 @@
+#include "render-queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+static bool compareKeys(const RenderItem& a, const RenderItem& b)
+{
+	return a.key < b.key;
+}
+
+int RenderQueueStats::getSubmittedTotal() const
+{
+	int total = 0;
+	for (int i = 0; i < RENDER_STATE_COUNT; i++)
+	{
+		total += submitted[i];
+	}
+	return total;
+}
+
+int RenderQueueStats::getExecutedTotal() const
+{
+	int total = 0;
+	for (int i = 0; i < RENDER_STATE_COUNT; i++)
+	{
+		total += executed[i];
+	}
+	return total;
+}
+
+void RenderQueue::clear()
+{
+	items.clear();
+	resetState(submittedState);
+
+	stats.draws = 0;
+	for (int i = 0; i < RENDER_STATE_COUNT; i++)
+	{
+		stats.submitted[i] = 0;
+		stats.executed[i] = 0;
+	}
+}
+
+void RenderQueue::push(const RenderItem& item, SortMode order)
+{
+	//As trocas na ordem de envio são contadas aqui, antes de a fila ser ordenada
+	countChanges(updateState(submittedState, item), stats.submitted);
+	stats.draws++;
+
+	items.push_back(item);
+	items.back().key = makeKey(order, item);
+}
+
+void RenderQueue::sort(int minRadixCount)
+{
+	size_t count = items.size();
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	//Com poucos draws limpar e percorrer os histogramas custa mais que comparar as chaves
+	if (count < (size_t)minRadixCount)
+	{
+		std::stable_sort(items.begin(), items.end(), compareKeys);
+		return;
+	}
+
+	//Histogramas dos 8 bytes da chave, todos em uma única leitura da fila
+	uint32_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t key = items[i].key;
+		for (int byte = 0; byte < 8; byte++)
+		{
+			histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+		}
+	}
+
+	scratch.resize(count);
+	RenderItem* source = &items[0];
+	RenderItem* target = &scratch[0];
+
+	//LSD: do byte menos significativo para o mais significativo, cada passada estável
+	for (int byte = 0; byte < 8; byte++)
+	{
+		uint32_t* histogram = histograms[byte];
+		int shift = byte * 8;
+
+		//Todas as chaves têm o mesmo valor neste byte: a passada não mudaria a ordem
+		if (histogram[(source[0].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		uint32_t offsets[256];
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			offsets[digit] = offset;
+			offset += histogram[digit];
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			target[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		RenderItem* swap = source;
+		source = target;
+		target = swap;
+	}
+
+	if (source != &items[0])
+	{
+		items.swap(scratch);
+	}
+}
+
+void RenderQueue::execute(const DrawFunction& draw)
+{
+	RenderItem bound;
+	resetState(bound);
+
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		unsigned int changes = updateState(bound, items[i]);
+		countChanges(changes, stats.executed);
+		draw(items[i], changes);
+	}
+
+	GL_STATS_ADD(STAT_STATE_CHANGES, stats.getExecutedTotal());
+	GL_STATS_ADD(STAT_STATE_CHANGES_AVOIDED, stats.getSubmittedTotal() - stats.getExecutedTotal());
+}
+
+uint64_t RenderQueue::makeKey(SortMode order, const RenderItem& item)
+{
+	//Floats positivos têm a mesma ordem dos seus bits como inteiros (negativos viram 0).
+	//O bit de sinal é sempre 0, então os 28 bits altos que sobram são os bits 30 a 3
+	uint32_t depthBits = 0;
+	if (item.depth > 0.0f)
+	{
+		memcpy(&depthBits, &item.depth, sizeof(depthBits));
+	}
+	uint64_t depth = depthBits >> (31 - DEPTH_BITS);
+
+	uint64_t state = item.program & ((1u << PROGRAM_BITS) - 1);
+	state = (state << MATERIAL_BITS) | (item.material & ((1u << MATERIAL_BITS) - 1));
+	state = (state << TEXTURE_BITS) | (item.texture & ((1u << TEXTURE_BITS) - 1));
+	state = (state << VERTEX_ARRAY_BITS) | (item.vertexArray & ((1u << VERTEX_ARRAY_BITS) - 1));
+
+	const int STATE_BITS = PROGRAM_BITS + MATERIAL_BITS + TEXTURE_BITS + VERTEX_ARRAY_BITS;
+	uint64_t pass = (uint64_t)(item.pass & ((1u << PASS_BITS) - 1)) << (DEPTH_BITS + STATE_BITS);
+
+	if (order == FRONT_TO_BACK)
+	{
+		return pass | (depth << STATE_BITS) | state;
+	}
+
+	return pass | (state << DEPTH_BITS) | depth;
+}
+
+void RenderQueue::resetState(RenderItem& state)
+{
+	//Nenhum id válido: o primeiro draw liga tudo o que usa
+	state.pass = ~0u;
+	state.program = ~0u;
+	state.material = ~0u;
+	state.texture = ~0u;
+	state.vertexArray = ~0u;
+}
+
+unsigned int RenderQueue::updateState(RenderItem& bound, const RenderItem& item)
+{
+	unsigned int changes = 0;
+
+	if (item.pass != bound.pass)
+	{
+		changes |= 1u << STATE_PASS;
+		bound.pass = item.pass;
+	}
+	if (item.program != bound.program)
+	{
+		changes |= 1u << STATE_PROGRAM;
+		bound.program = item.program;
+
+		//Os uniforms do material são do programa, então um programa novo precisa deles de novo
+		bound.material = ~0u;
+	}
+
+	//Id 0: o draw não usa o estado, e o que estava ligado continua valendo para os próximos
+	if (item.material != 0 && item.material != bound.material)
+	{
+		changes |= 1u << STATE_MATERIAL;
+		bound.material = item.material;
+	}
+	if (item.texture != 0 && item.texture != bound.texture)
+	{
+		changes |= 1u << STATE_TEXTURE;
+		bound.texture = item.texture;
+	}
+	if (item.vertexArray != 0 && item.vertexArray != bound.vertexArray)
+	{
+		changes |= 1u << STATE_VERTEX_ARRAY;
+		bound.vertexArray = item.vertexArray;
+	}
+
+	return changes;
+}
+
+void RenderQueue::countChanges(unsigned int changes, int* counts)
+{
+	for (int i = 0; i < RENDER_STATE_COUNT; i++)
+	{
+		if (changes & (1u << i))
+		{
+			counts[i]++;
+		}
+	}
+}
@@ -0,0 +1,196 @@
+#include "scene-graph.h"
+
+#include <algorithm>
+
+int SceneGraph::createNode(int parent, glm::vec3 position, glm::vec3 scale, glm::quat rotation)
+{
+	if (parent >= size())
+	{
+		parent = -1;
+	}
+
+	int node = size();
+	parentHandles.push_back(parent);
+	indices.push_back((int)handles.size());
+
+	//O nó novo vai para o fim, o que já mantém os pais antes dos filhos;
+	//a ordem em largura é refeita no próximo updateWorld()
+	handles.push_back(node);
+	parents.push_back(parent >= 0 ? indices[parent] : -1);
+	dirty.push_back(1);
+	world.push_back(glm::mat4(1));
+	locals.create(position, scale, rotation);
+
+	structureDirty = true;
+	return node;
+}
+
+bool SceneGraph::setParent(int node, int parent)
+{
+	if (parent >= size())
+	{
+		parent = -1;
+	}
+
+	//Não deixa um nó virar descendente de si mesmo
+	for (int ancestor = parent; ancestor >= 0; ancestor = parentHandles[ancestor])
+	{
+		if (ancestor == node)
+		{
+			return false;
+		}
+	}
+
+	parentHandles[node] = parent;
+	markDirty(node);
+	structureDirty = true;
+	return true;
+}
+
+void SceneGraph::setPosition(int node, glm::vec3 position)
+{
+	locals.setPosition(indices[node], position);
+	markDirty(node);
+}
+
+void SceneGraph::setScale(int node, glm::vec3 scale)
+{
+	locals.setScale(indices[node], scale);
+	markDirty(node);
+}
+
+void SceneGraph::setRotation(int node, glm::quat rotation)
+{
+	locals.setRotation(indices[node], rotation);
+	markDirty(node);
+}
+
+void SceneGraph::setRotation(int node, float angle, glm::vec3 axis)
+{
+	locals.setRotation(indices[node], angle, axis);
+	markDirty(node);
+}
+
+void SceneGraph::rotate(int node, float angle, glm::vec3 axis)
+{
+	locals.rotate(indices[node], angle, axis);
+	markDirty(node);
+}
+
+void SceneGraph::updateWorld()
+{
+	if (structureDirty)
+	{
+		rebuildOrder();
+	}
+
+	int count = (int)handles.size();
+	lastUpdateCount = 0;
+
+	//Como todo pai vem antes dos filhos, quando um nó é visitado o seu pai já está
+	//atualizado e já passou a sujeira adiante
+	for (int i = 0; i < count; i++)
+	{
+		int parent = parents[i];
+
+		if (parent >= 0 && dirty[parent])
+		{
+			dirty[i] = 1;
+		}
+
+		if (dirty[i])
+		{
+			//Em locals nenhum nó tem pai, então computeModel devolve só a matriz local
+			glm::mat4 local = locals.computeModel(i);
+			world[i] = parent >= 0 ? world[parent] * local : local;
+			lastUpdateCount++;
+		}
+	}
+
+	std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+void SceneGraph::updateAllWorld()
+{
+	std::fill(dirty.begin(), dirty.end(), 1);
+	updateWorld();
+}
+
+void SceneGraph::rebuildOrder()
+{
+	int count = size();
+
+	//Filhos de cada nó em listas contíguas (por handle, na ordem de criação)
+	vector <int> childStart(count + 1, 0);
+	vector <int> children(count);
+
+	for (int node = 0; node < count; node++)
+	{
+		if (parentHandles[node] >= 0)
+		{
+			childStart[parentHandles[node] + 1]++;
+		}
+	}
+
+	for (int node = 0; node < count; node++)
+	{
+		childStart[node + 1] += childStart[node];
+	}
+
+	vector <int> next(childStart.begin(), childStart.end() - 1);
+	for (int node = 0; node < count; node++)
+	{
+		if (parentHandles[node] >= 0)
+		{
+			children[next[parentHandles[node]]++] = node;
+		}
+	}
+
+	//Busca em largura a partir das raízes: a própria lista de saída serve de fila
+	vector <int> order;
+	order.reserve(count);
+
+	for (int node = 0; node < count; node++)
+	{
+		if (parentHandles[node] < 0)
+		{
+			order.push_back(node);
+		}
+	}
+
+	for (size_t head = 0; head < order.size(); head++)
+	{
+		int node = order[head];
+		order.insert(order.end(), children.begin() + childStart[node], children.begin() + childStart[node + 1]);
+	}
+
+	//Reordena os arrays
+	TransformSystem newLocals;
+	vector <char> newDirty(count);
+	vector <glm::mat4> newWorld(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		int old = indices[order[i]];
+		newLocals.create(locals.getPosition(old), locals.getScale(old), locals.getRotation(old));
+		newDirty[i] = dirty[old];
+		newWorld[i] = world[old];
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		indices[order[i]] = i;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		int parent = parentHandles[order[i]];
+		parents[i] = parent >= 0 ? indices[parent] : -1;
+	}
+
+	handles.swap(order);
+	dirty.swap(newDirty);
+	world.swap(newWorld);
+	locals = newLocals;
+	structureDirty = false;
+}
@@ -0,0 +1,107 @@
+#include "shader-permutations.h"
+
+//Nome do #define de cada recurso, na ordem dos bits de ShaderFeature
+static const char* FEATURE_NAMES[SHADER_FEATURE_COUNT] = { "TEXTURED", "LIT", "SPECULAR", "VERTEX_COLOR", "INSTANCED", "CLUSTERED", "DEFERRED" };
+
+void ShaderPermutations::initialize(const string& vertexPath, const string& fragmentPath, SetupFunction setup)
+{
+	this->vertexPath = vertexPath;
+	this->fragmentPath = fragmentPath;
+	this->setup = setup;
+}
+
+Shader* ShaderPermutations::get(unsigned int features)
+{
+	//Especular e luzes pontuais sem iluminação não têm efeito, então essas combinações são a mesma variante
+	if (!(features & SHADER_LIT))
+	{
+		features &= ~(SHADER_SPECULAR | SHADER_CLUSTERED);
+	}
+
+	//No G-buffer as luzes pontuais são somadas depois, pelo DeferredRenderer
+	if (features & SHADER_DEFERRED)
+	{
+		features &= ~SHADER_CLUSTERED;
+	}
+
+	map <unsigned int, Shader*>::iterator found = variants.find(features);
+	if (found != variants.end())
+	{
+		return found->second;
+	}
+
+	Shader* shader = new Shader(vertexPath.c_str(), fragmentPath.c_str(), getDefines(features));
+	variants[features] = shader;
+
+	if (setup)
+	{
+		shader->Use();
+		setup(*shader, features);
+	}
+
+	return shader;
+}
+
+void ShaderPermutations::release()
+{
+	for (map <unsigned int, Shader*>::iterator it = variants.begin(); it != variants.end(); ++it)
+	{
+		glDeleteProgram(it->second->ID);
+		delete it->second;
+	}
+
+	variants.clear();
+}
+
+unsigned int ShaderPermutations::selectFeatures(const Material& material)
+{
+	unsigned int features = 0;
+
+	if (!material.texturePath.empty())
+	{
+		features |= SHADER_TEXTURED;
+	}
+
+	if (material.illumination >= 1)
+	{
+		features |= SHADER_LIT;
+	}
+
+	//Com ks zerado o termo especular nunca contribui
+	if (material.illumination >= 2 && material.shininess > 0.0f && glm::length(material.specular) > 0.0f)
+	{
+		features |= SHADER_SPECULAR;
+	}
+
+	return features;
+}
+
+string ShaderPermutations::getDefines(unsigned int features)
+{
+	string defines;
+
+	for (int i = 0; i < SHADER_FEATURE_COUNT; i++)
+	{
+		if (features & (1u << i))
+		{
+			defines += string("#define ") + FEATURE_NAMES[i] + "\n";
+		}
+	}
+
+	return defines;
+}
+
+string ShaderPermutations::getName(unsigned int features)
+{
+	string name;
+
+	for (int i = 0; i < SHADER_FEATURE_COUNT; i++)
+	{
+		if (features & (1u << i))
+		{
+			name += (name.empty() ? "" : "|") + string(FEATURE_NAMES[i]);
+		}
+	}
+
+	return name.empty() ? "NONE" : name;
+}
@@ -0,0 +1,84 @@
+#include "transform-system.h"
+
+//Mesmo resultado de translate * rotate * scale, mas montando as colunas direto a partir
+//do quaternion, sem multiplicações de matrizes
+static inline void composeModel(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& model)
+{
+	float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+	float xx = x * x, yy = y * y, zz = z * z;
+	float xy = x * y, xz = x * z, yz = y * z;
+	float wx = w * x, wy = w * y, wz = w * z;
+
+	model[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+	model[1] = glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+	model[2] = glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+	model[3] = glm::vec4(position, 1.0f);
+}
+
+int TransformSystem::create(glm::vec3 position, glm::vec3 scale, glm::quat rotation, int parent)
+{
+	//O pai precisa existir antes do filho para que a hierarquia seja resolvida em ordem
+	if (parent >= size())
+	{
+		parent = -1;
+	}
+
+	positions.push_back(position);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+	parents.push_back(parent);
+
+	return size() - 1;
+}
+
+void TransformSystem::setRotation(int object, float angle, glm::vec3 axis)
+{
+	rotations[object] = glm::angleAxis(angle, glm::normalize(axis));
+}
+
+void TransformSystem::rotate(int object, float angle, glm::vec3 axis)
+{
+	rotations[object] = glm::normalize(glm::angleAxis(angle, glm::normalize(axis)) * rotations[object]);
+}
+
+void TransformSystem::computeModels(int begin, int end, glm::mat4* models) const
+{
+	const glm::vec3* position = positions.data();
+	const glm::quat* rotation = rotations.data();
+	const glm::vec3* scale = scales.data();
+	const int* parent = parents.data();
+
+	//Uma passada linear pelos arrays, sem dependência entre iterações
+	for (int i = begin; i < end; i++)
+	{
+		composeModel(position[i], rotation[i], scale[i], models[i]);
+	}
+
+	//Objetos com pai: a matriz do pai é recalculada a partir dos arrays (models pode não ser legível)
+	for (int i = begin; i < end; i++)
+	{
+		if (parent[i] >= 0)
+		{
+			models[i] = computeModel(i);
+		}
+	}
+}
+
+glm::mat4 TransformSystem::computeModel(int object) const
+{
+	glm::mat4 model = computeLocal(object);
+
+	for (int parent = parents[object]; parent >= 0; parent = parents[parent])
+	{
+		model = computeLocal(parent) * model;
+	}
+
+	return model;
+}
+
+glm::mat4 TransformSystem::computeLocal(int object) const
+{
+	glm::mat4 model;
+	composeModel(positions[object], rotations[object], scales[object], model);
+	return model;
+}
@@ -0,0 +1,588 @@
+#include "triangle-bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+//Operações de 4 floats: SSE em x86, NEON em ARM de 64 bits e um laço escalar nas
+//outras arquiteturas. As comparações retornam máscaras com todos os bits de cada lane
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+
+typedef __m128 Float4;
+
+static inline Float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, Float4 a) { _mm_storeu_ps(p, a); }
+static inline Float4 splat4(float x) { return _mm_set1_ps(x); }
+static inline Float4 add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+static inline Float4 sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+static inline Float4 mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+static inline Float4 div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+static inline Float4 min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+static inline Float4 max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+static inline Float4 less4(Float4 a, Float4 b) { return _mm_cmplt_ps(a, b); }
+static inline Float4 lessEqual4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+static inline Float4 and4(Float4 a, Float4 b) { return _mm_and_ps(a, b); }
+static inline Float4 select4(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline int mask4(Float4 mask) { return _mm_movemask_ps(mask); }
+
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+
+typedef float32x4_t Float4;
+
+static inline Float4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, Float4 a) { vst1q_f32(p, a); }
+static inline Float4 splat4(float x) { return vdupq_n_f32(x); }
+static inline Float4 add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+static inline Float4 sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+static inline Float4 mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+static inline Float4 div4(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+static inline Float4 min4(Float4 a, Float4 b) { return vminq_f32(a, b); }
+static inline Float4 max4(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+static inline Float4 less4(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+static inline Float4 lessEqual4(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vcleq_f32(a, b)); }
+static inline Float4 and4(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+static inline Float4 select4(Float4 mask, Float4 a, Float4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+static inline int mask4(Float4 mask)
+{
+	//O bit de sinal de cada lane na posição do lane, como o movemask do SSE
+	static const int32_t shifts[4] = { 0, 1, 2, 3 };
+	uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+	return (int)vaddvq_u32(vshlq_u32(signs, vld1q_s32(shifts)));
+}
+
+#else
+
+struct Float4
+{
+	float v[4];
+};
+
+static inline float maskLane(bool value)
+{
+	uint32_t bits = value ? 0xFFFFFFFFu : 0u;
+	float lane;
+	memcpy(&lane, &bits, sizeof(lane));
+	return lane;
+}
+
+static inline uint32_t laneBits(float lane)
+{
+	uint32_t bits;
+	memcpy(&bits, &lane, sizeof(bits));
+	return bits;
+}
+
+static inline Float4 load4(const float* p) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = p[i]; return r; }
+static inline void store4(float* p, Float4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+static inline Float4 splat4(float x) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = x; return r; }
+static inline Float4 add4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+static inline Float4 sub4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+static inline Float4 mul4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+static inline Float4 div4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; }
+static inline Float4 min4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return a; }
+static inline Float4 max4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+static inline Float4 less4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = maskLane(a.v[i] < b.v[i]); return a; }
+static inline Float4 lessEqual4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = maskLane(a.v[i] <= b.v[i]); return a; }
+static inline Float4 and4(Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = maskLane(laneBits(a.v[i]) && laneBits(b.v[i])); return a; }
+static inline Float4 select4(Float4 mask, Float4 a, Float4 b) { for (int i = 0; i < 4; i++) a.v[i] = laneBits(mask.v[i]) ? a.v[i] : b.v[i]; return a; }
+static inline int mask4(Float4 mask) { int m = 0; for (int i = 0; i < 4; i++) m |= (laneBits(mask.v[i]) >> 31) << i; return m; }
+
+#endif
+
+//Abaixo disso o raio é considerado paralelo ao triângulo
+static const float MIN_DETERMINANT = 1e-12f;
+static const float LANE_INDICES[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+//Cada nó empilha até 4 filhos, e a árvore de 4 filhos tem no máximo a profundidade da binária
+static const int STACK_SIZE = Bvh::MAX_DEPTH * 4;
+
+static float getArea(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 extent = max - min;
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+//Filhos acertados de um nó, do mais distante para o mais próximo (a ordem de empilhar)
+static int sortChildren(int hitMask, const float* entries, int* order)
+{
+	int count = 0;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (!(hitMask & (1 << lane)))
+		{
+			continue;
+		}
+		int i = count++;
+		while (i > 0 && entries[order[i - 1]] < entries[lane])
+		{
+			order[i] = order[i - 1];
+			i--;
+		}
+		order[i] = lane;
+	}
+	return count;
+}
+
+void TriangleBvh::build(const vector <float>& vertices, int vertexFloats)
+{
+	int triangleCount = (int)vertices.size() / (3 * vertexFloats);
+	vector <glm::vec3> corners(triangleCount * 3), mins(triangleCount), maxs(triangleCount);
+
+	for (int t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* position = &vertices[(t * 3 + corner) * vertexFloats];
+			corners[t * 3 + corner] = glm::vec3(position[0], position[1], position[2]);
+		}
+		mins[t] = glm::min(corners[t * 3], glm::min(corners[t * 3 + 1], corners[t * 3 + 2]));
+		maxs[t] = glm::max(corners[t * 3], glm::max(corners[t * 3 + 1], corners[t * 3 + 2]));
+	}
+
+	binary.build(mins.data(), maxs.data(), triangleCount);
+	triangleIds = binary.getItemIds();
+	triangleSlots.resize(triangleCount);
+	for (int slot = 0; slot < triangleCount; slot++)
+	{
+		triangleSlots[triangleIds[slot]] = slot;
+	}
+
+	vector <float>* arrays[9] = { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z };
+	for (int i = 0; i < 9; i++)
+	{
+		arrays[i]->assign(triangleCount + 3, 0.0f);
+	}
+
+	for (int slot = 0; slot < triangleCount; slot++)
+	{
+		const glm::vec3* triangle = &corners[triangleIds[slot] * 3];
+		glm::vec3 e1 = triangle[1] - triangle[0], e2 = triangle[2] - triangle[0];
+		v0x[slot] = triangle[0].x; v0y[slot] = triangle[0].y; v0z[slot] = triangle[0].z;
+		e1x[slot] = e1.x; e1y[slot] = e1.y; e1z[slot] = e1.z;
+		e2x[slot] = e2.x; e2y[slot] = e2.y; e2z[slot] = e2.z;
+	}
+
+	nodes.clear();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//Uma malha pequena cabe em uma folha: a raiz de 4 filhos tem só ela
+	const BvhNode& root = binary.getNodes()[0];
+	if (root.count > 0)
+	{
+		nodes.push_back(TriangleBvhNode());
+		setChild(nodes[0], 0, &root);
+		for (int lane = 1; lane < 4; lane++)
+		{
+			setChild(nodes[0], lane, nullptr);
+		}
+		return;
+	}
+
+	convertNode(0);
+}
+
+int TriangleBvh::convertNode(int binaryNode)
+{
+	const vector <BvhNode>& binaryNodes = binary.getNodes();
+
+	//Os filhos do nó binário, trocando o filho interno de maior área pelos filhos dele até serem 4
+	int candidates[4];
+	int count = 2;
+	candidates[0] = binaryNodes[binaryNode].leftFirst;
+	candidates[1] = candidates[0] + 1;
+
+	while (count < 4)
+	{
+		int largest = -1;
+		float largestArea = -1.0f;
+		for (int i = 0; i < count; i++)
+		{
+			const BvhNode& candidate = binaryNodes[candidates[i]];
+			float area = getArea(candidate.min, candidate.max);
+			if (candidate.count == 0 && area > largestArea)
+			{
+				largest = i;
+				largestArea = area;
+			}
+		}
+		if (largest < 0)
+		{
+			break;
+		}
+
+		int expanded = candidates[largest];
+		candidates[largest] = binaryNodes[expanded].leftFirst;
+		candidates[count++] = binaryNodes[expanded].leftFirst + 1;
+	}
+
+	int index = (int)nodes.size();
+	nodes.push_back(TriangleBvhNode());
+	for (int lane = 0; lane < 4; lane++)
+	{
+		setChild(nodes[index], lane, lane < count ? &binaryNodes[candidates[lane]] : nullptr);
+	}
+
+	//O vetor pode ser realocado nas chamadas recursivas: o nó é acessado pelo índice depois delas
+	for (int lane = 0; lane < count; lane++)
+	{
+		if (binaryNodes[candidates[lane]].count == 0)
+		{
+			int child = convertNode(candidates[lane]);
+			nodes[index].children[lane] = child;
+		}
+	}
+
+	return index;
+}
+
+void TriangleBvh::setChild(TriangleBvhNode& node, int lane, const BvhNode* child)
+{
+	//Sem filho, a caixa vazia nunca é acertada e o lane é marcado com -1
+	BvhNode empty = { glm::vec3(FLT_MAX), 0, glm::vec3(-FLT_MAX), -1 };
+	if (!child)
+	{
+		child = &empty;
+	}
+
+	node.minX[lane] = child->min.x;
+	node.minY[lane] = child->min.y;
+	node.minZ[lane] = child->min.z;
+	node.maxX[lane] = child->max.x;
+	node.maxY[lane] = child->max.y;
+	node.maxZ[lane] = child->max.z;
+	node.children[lane] = child->leftFirst;
+	node.counts[lane] = child->count;
+}
+
+bool TriangleBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+	hit.triangle = -1;
+	hit.distance = maxDistance;
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	Float4 ox = splat4(origin.x), oy = splat4(origin.y), oz = splat4(origin.z);
+	Float4 dx = splat4(direction.x), dy = splat4(direction.y), dz = splat4(direction.z);
+	glm::vec3 inverseDirection = Bvh::getInverseDirection(direction);
+	Float4 ix = splat4(inverseDirection.x), iy = splat4(inverseDirection.y), iz = splat4(inverseDirection.z);
+	Float4 zero = splat4(0.0f), one = splat4(1.0f), minDeterminant = splat4(MIN_DETERMINANT);
+	Float4 laneIndices = load4(LANE_INDICES);
+
+	//Nós internos (count 0) e folhas vão para a mesma pilha, com a distância de entrada
+	int stackNodes[STACK_SIZE], stackCounts[STACK_SIZE];
+	float stackEntries[STACK_SIZE];
+	int size = 1;
+	stackNodes[0] = 0;
+	stackCounts[0] = 0;
+	stackEntries[0] = 0.0f;
+
+	while (size > 0)
+	{
+		size--;
+		if (stackEntries[size] > hit.distance)
+		{
+			continue;
+		}
+
+		int first = stackNodes[size], count = stackCounts[size];
+		if (count == 0)
+		{
+			//Slabs das 4 caixas filhas de uma vez
+			const TriangleBvhNode& node = nodes[first];
+			Float4 t0x = mul4(sub4(load4(node.minX), ox), ix), t1x = mul4(sub4(load4(node.maxX), ox), ix);
+			Float4 t0y = mul4(sub4(load4(node.minY), oy), iy), t1y = mul4(sub4(load4(node.maxY), oy), iy);
+			Float4 t0z = mul4(sub4(load4(node.minZ), oz), iz), t1z = mul4(sub4(load4(node.maxZ), oz), iz);
+			Float4 entry = max4(max4(min4(t0x, t1x), min4(t0y, t1y)), max4(min4(t0z, t1z), zero));
+			Float4 exit = min4(min4(max4(t0x, t1x), max4(t0y, t1y)), min4(max4(t0z, t1z), splat4(hit.distance)));
+
+			int hitMask = mask4(lessEqual4(entry, exit));
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (node.counts[lane] < 0)
+				{
+					hitMask &= ~(1 << lane);
+				}
+			}
+
+			float entries[4];
+			int order[4];
+			store4(entries, entry);
+			int hits = sortChildren(hitMask, entries, order);
+			for (int i = 0; i < hits; i++)
+			{
+				stackNodes[size] = node.children[order[i]];
+				stackCounts[size] = node.counts[order[i]];
+				stackEntries[size++] = entries[order[i]];
+			}
+			continue;
+		}
+
+		//Möller-Trumbore em 4 triângulos da folha por vez; os lanes além da folha são ignorados
+		for (int base = first; base < first + count; base += 4)
+		{
+			Float4 valid = less4(laneIndices, splat4((float)(first + count - base)));
+			Float4 edge1x = load4(&e1x[base]), edge1y = load4(&e1y[base]), edge1z = load4(&e1z[base]);
+			Float4 edge2x = load4(&e2x[base]), edge2y = load4(&e2y[base]), edge2z = load4(&e2z[base]);
+
+			Float4 px = sub4(mul4(dy, edge2z), mul4(dz, edge2y));
+			Float4 py = sub4(mul4(dz, edge2x), mul4(dx, edge2z));
+			Float4 pz = sub4(mul4(dx, edge2y), mul4(dy, edge2x));
+			Float4 determinant = add4(add4(mul4(edge1x, px), mul4(edge1y, py)), mul4(edge1z, pz));
+			Float4 inverseDeterminant = div4(one, determinant);
+
+			Float4 tx = sub4(ox, load4(&v0x[base])), ty = sub4(oy, load4(&v0y[base])), tz = sub4(oz, load4(&v0z[base]));
+			Float4 u = mul4(add4(add4(mul4(tx, px), mul4(ty, py)), mul4(tz, pz)), inverseDeterminant);
+
+			Float4 qx = sub4(mul4(ty, edge1z), mul4(tz, edge1y));
+			Float4 qy = sub4(mul4(tz, edge1x), mul4(tx, edge1z));
+			Float4 qz = sub4(mul4(tx, edge1y), mul4(ty, edge1x));
+			Float4 v = mul4(add4(add4(mul4(dx, qx), mul4(dy, qy)), mul4(dz, qz)), inverseDeterminant);
+			Float4 distance = mul4(add4(add4(mul4(edge2x, qx), mul4(edge2y, qy)), mul4(edge2z, qz)), inverseDeterminant);
+
+			Float4 accepted = and4(valid, less4(minDeterminant, max4(determinant, sub4(zero, determinant))));
+			accepted = and4(accepted, and4(lessEqual4(zero, u), lessEqual4(zero, v)));
+			accepted = and4(accepted, lessEqual4(add4(u, v), one));
+			accepted = and4(accepted, and4(lessEqual4(zero, distance), less4(distance, splat4(hit.distance))));
+
+			int acceptedMask = mask4(accepted);
+			if (acceptedMask)
+			{
+				float distances[4], us[4], vs[4];
+				store4(distances, distance);
+				store4(us, u);
+				store4(vs, v);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((acceptedMask & (1 << lane)) && distances[lane] < hit.distance)
+					{
+						hit.triangle = triangleIds[base + lane];
+						hit.distance = distances[lane];
+						hit.u = us[lane];
+						hit.v = vs[lane];
+					}
+				}
+			}
+		}
+	}
+
+	return hit.triangle >= 0;
+}
+
+void TriangleBvh::raycastPacket(const glm::vec3* origins, const glm::vec3* directions, float maxDistance, RayHit* hits) const
+{
+	for (int ray = 0; ray < 4; ray++)
+	{
+		hits[ray].triangle = -1;
+		hits[ray].distance = maxDistance;
+	}
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	//Um raio por lane
+	float packet[9][4];
+	for (int ray = 0; ray < 4; ray++)
+	{
+		glm::vec3 inverseDirection = Bvh::getInverseDirection(directions[ray]);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			packet[axis][ray] = origins[ray][axis];
+			packet[3 + axis][ray] = directions[ray][axis];
+			packet[6 + axis][ray] = inverseDirection[axis];
+		}
+	}
+	Float4 ox = load4(packet[0]), oy = load4(packet[1]), oz = load4(packet[2]);
+	Float4 dx = load4(packet[3]), dy = load4(packet[4]), dz = load4(packet[5]);
+	Float4 ix = load4(packet[6]), iy = load4(packet[7]), iz = load4(packet[8]);
+	Float4 zero = splat4(0.0f), one = splat4(1.0f), minDeterminant = splat4(MIN_DETERMINANT);
+	Float4 closest = splat4(maxDistance);
+
+	int stackNodes[STACK_SIZE], stackCounts[STACK_SIZE];
+	float stackEntries[STACK_SIZE];
+	int size = 1;
+	stackNodes[0] = 0;
+	stackCounts[0] = 0;
+	stackEntries[0] = 0.0f;
+
+	while (size > 0)
+	{
+		size--;
+
+		//O nó é pulado só se começa depois do acerto mais próximo de todos os raios
+		float distances[4];
+		store4(distances, closest);
+		float farthest = std::max(std::max(distances[0], distances[1]), std::max(distances[2], distances[3]));
+		if (stackEntries[size] > farthest)
+		{
+			continue;
+		}
+
+		int first = stackNodes[size], count = stackCounts[size];
+		if (count == 0)
+		{
+			//Cada caixa filha contra os 4 raios; o filho é visitado se algum raio a acerta
+			const TriangleBvhNode& node = nodes[first];
+			float entries[4];
+			int hitMask = 0;
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (node.counts[lane] < 0)
+				{
+					continue;
+				}
+
+				Float4 t0x = mul4(sub4(splat4(node.minX[lane]), ox), ix), t1x = mul4(sub4(splat4(node.maxX[lane]), ox), ix);
+				Float4 t0y = mul4(sub4(splat4(node.minY[lane]), oy), iy), t1y = mul4(sub4(splat4(node.maxY[lane]), oy), iy);
+				Float4 t0z = mul4(sub4(splat4(node.minZ[lane]), oz), iz), t1z = mul4(sub4(splat4(node.maxZ[lane]), oz), iz);
+				Float4 entry = max4(max4(min4(t0x, t1x), min4(t0y, t1y)), max4(min4(t0z, t1z), zero));
+				Float4 exit = min4(min4(max4(t0x, t1x), max4(t0y, t1y)), min4(max4(t0z, t1z), closest));
+
+				int rays = mask4(lessEqual4(entry, exit));
+				if (rays)
+				{
+					//A entrada do filho é a do raio que entra primeiro
+					float rayEntries[4];
+					store4(rayEntries, entry);
+					entries[lane] = FLT_MAX;
+					for (int ray = 0; ray < 4; ray++)
+					{
+						if (rays & (1 << ray))
+						{
+							entries[lane] = std::min(entries[lane], rayEntries[ray]);
+						}
+					}
+					hitMask |= 1 << lane;
+				}
+			}
+
+			int order[4];
+			int childHits = sortChildren(hitMask, entries, order);
+			for (int i = 0; i < childHits; i++)
+			{
+				stackNodes[size] = node.children[order[i]];
+				stackCounts[size] = node.counts[order[i]];
+				stackEntries[size++] = entries[order[i]];
+			}
+			continue;
+		}
+
+		//Cada triângulo da folha contra os 4 raios
+		for (int slot = first; slot < first + count; slot++)
+		{
+			Float4 edge1x = splat4(e1x[slot]), edge1y = splat4(e1y[slot]), edge1z = splat4(e1z[slot]);
+			Float4 edge2x = splat4(e2x[slot]), edge2y = splat4(e2y[slot]), edge2z = splat4(e2z[slot]);
+
+			Float4 px = sub4(mul4(dy, edge2z), mul4(dz, edge2y));
+			Float4 py = sub4(mul4(dz, edge2x), mul4(dx, edge2z));
+			Float4 pz = sub4(mul4(dx, edge2y), mul4(dy, edge2x));
+			Float4 determinant = add4(add4(mul4(edge1x, px), mul4(edge1y, py)), mul4(edge1z, pz));
+			Float4 inverseDeterminant = div4(one, determinant);
+
+			Float4 tx = sub4(ox, splat4(v0x[slot])), ty = sub4(oy, splat4(v0y[slot])), tz = sub4(oz, splat4(v0z[slot]));
+			Float4 u = mul4(add4(add4(mul4(tx, px), mul4(ty, py)), mul4(tz, pz)), inverseDeterminant);
+
+			Float4 qx = sub4(mul4(ty, edge1z), mul4(tz, edge1y));
+			Float4 qy = sub4(mul4(tz, edge1x), mul4(tx, edge1z));
+			Float4 qz = sub4(mul4(tx, edge1y), mul4(ty, edge1x));
+			Float4 v = mul4(add4(add4(mul4(dx, qx), mul4(dy, qy)), mul4(dz, qz)), inverseDeterminant);
+			Float4 distance = mul4(add4(add4(mul4(edge2x, qx), mul4(edge2y, qy)), mul4(edge2z, qz)), inverseDeterminant);
+
+			Float4 accepted = less4(minDeterminant, max4(determinant, sub4(zero, determinant)));
+			accepted = and4(accepted, and4(lessEqual4(zero, u), lessEqual4(zero, v)));
+			accepted = and4(accepted, lessEqual4(add4(u, v), one));
+			accepted = and4(accepted, and4(lessEqual4(zero, distance), less4(distance, closest)));
+
+			int acceptedMask = mask4(accepted);
+			if (acceptedMask)
+			{
+				closest = select4(accepted, distance, closest);
+
+				float us[4], vs[4];
+				store4(us, u);
+				store4(vs, v);
+				for (int ray = 0; ray < 4; ray++)
+				{
+					if (acceptedMask & (1 << ray))
+					{
+						hits[ray].triangle = triangleIds[slot];
+						hits[ray].u = us[ray];
+						hits[ray].v = vs[ray];
+					}
+				}
+			}
+		}
+	}
+
+	float distances[4];
+	store4(distances, closest);
+	for (int ray = 0; ray < 4; ray++)
+	{
+		hits[ray].distance = distances[ray];
+	}
+}
+
+bool TriangleBvh::raycastScalar(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+	float u = 0.0f, v = 0.0f, closestU = 0.0f, closestV = 0.0f;
+
+	//O Bvh chama a função com o índice original do triângulo
+	hit.triangle = binary.raycast(origin, direction, maxDistance, hit.distance, [&](int triangle, float closest)
+	{
+		int slot = triangleSlots[triangle];
+		glm::vec3 v0(v0x[slot], v0y[slot], v0z[slot]);
+		glm::vec3 v1 = v0 + glm::vec3(e1x[slot], e1y[slot], e1z[slot]);
+		glm::vec3 v2 = v0 + glm::vec3(e2x[slot], e2y[slot], e2z[slot]);
+		float distance = intersectTriangle(origin, direction, v0, v1, v2, closest, u, v);
+		if (distance >= 0.0f)
+		{
+			closestU = u;
+			closestV = v;
+		}
+		return distance;
+	});
+
+	hit.u = closestU;
+	hit.v = closestV;
+	return hit.triangle >= 0;
+}
+
+float TriangleBvh::intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2,
+	float maxDistance, float& u, float& v)
+{
+	glm::vec3 edge1 = v1 - v0, edge2 = v2 - v0;
+	glm::vec3 p = glm::cross(direction, edge2);
+	float determinant = glm::dot(edge1, p);
+	if (fabs(determinant) <= MIN_DETERMINANT)
+	{
+		return -1.0f;
+	}
+
+	float inverseDeterminant = 1.0f / determinant;
+	glm::vec3 t = origin - v0;
+	u = glm::dot(t, p) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return -1.0f;
+	}
+
+	glm::vec3 q = glm::cross(t, edge1);
+	v = glm::dot(direction, q) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return -1.0f;
+	}
+
+	float distance = glm::dot(edge2, q) * inverseDeterminant;
+	return distance >= 0.0f && distance < maxDistance ? distance : -1.0f;
+}
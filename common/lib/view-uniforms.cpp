@@ -0,0 +1,72 @@
+#include "view-uniforms.h"
+
+void ViewUniforms::initialize(int maxViews)
+{
+	this->maxViews = maxViews;
+
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	stride = ((GLint)sizeof(ViewBlock) + alignment - 1) / alignment * alignment;
+
+	cameras.assign(maxViews, (const Camera*)NULL);
+	revisions.assign(maxViews, 0);
+
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, stride * maxViews, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	bind(0);
+}
+
+void ViewUniforms::attach(const Shader& shader, const char* blockName) const
+{
+	GLuint blockIndex = glGetUniformBlockIndex(shader.ID, blockName);
+
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		std::cout << "ERROR::VIEW_UNIFORMS::BLOCK_NOT_FOUND " << blockName << std::endl;
+		return;
+	}
+
+	glUniformBlockBinding(shader.ID, blockIndex, BINDING);
+}
+
+void ViewUniforms::update(int view, const Camera& camera)
+{
+	//A câmera não mudou desde o último envio para este slot
+	if (cameras[view] == &camera && revisions[view] == camera.getRevision())
+	{
+		return;
+	}
+
+	ViewBlock block;
+	block.view = camera.getViewMatrix();
+	block.projection = camera.getProjectionMatrix();
+	block.viewProjection = camera.getViewProjectionMatrix();
+	block.cameraPos = glm::vec4(camera.getPosition(), 1.0f);
+
+	GL_STATS_COUNT(STAT_BUFFER_UPLOADS);
+	GL_STATS_ADD(STAT_BUFFER_BYTES, sizeof(ViewBlock));
+
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, view * stride, sizeof(ViewBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	cameras[view] = &camera;
+	revisions[view] = camera.getRevision();
+}
+
+void ViewUniforms::bind(int view) const
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, UBO, view * stride, sizeof(ViewBlock));
+}
+
+void ViewUniforms::release()
+{
+	if (UBO)
+	{
+		glDeleteBuffers(1, &UBO);
+		UBO = 0;
+	}
+}
@@ -1,3 +1,4 @@
+#include <cfloat>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -23,66 +24,260 @@ using namespace std;
 #include "stb_image.h"
 #include "Shader.h"
 #include "camera.h"
+#include "view-uniforms.h"
 #include "bezier.h"
+#include "curve-batch.h"
 #include "mesh.h"
+#include "scene-graph.h"
+#include "instance-buffer.h"
+#include "shader-permutations.h"
+#include "light-clusters.h"
+#include "deferred-renderer.h"
+#include "render-queue.h"
+#include "mesh-simplifier.h"
+#include "bvh.h"
+#include "triangle-bvh.h"
+#include "occlusion-culler.h"
+#include "frame-clock.h"
+#include "profiler.h"
+#include "gl-stats.h"
+#include "simulation-thread.h"
+#include "job-system.h"
 
 #include "./utils/obj-utils.hpp"
 #include "./utils/animations-utils.hpp"
+#include "./utils/headless-utils.hpp"
+#include "./utils/replay-utils.hpp"
+#include "./utils/depth-utils.hpp"
+#include "./utils/job-benchmark.hpp"
+#include "./utils/scene-benchmark.hpp"
+#include "./utils/light-benchmark.hpp"
+#include "./utils/sort-benchmark.hpp"
+#include "./utils/bvh-benchmark.hpp"
+#include "./utils/ray-benchmark.hpp"
+#include "./utils/occlusion-benchmark.hpp"
+#include "./utils/curve-benchmark.hpp"
+#include "./utils/animation-benchmark.hpp"
 
 const string ASSETS_FOLDER = "./assets/";
 const string MOON_OBJ_FILE_PATH = ASSETS_FOLDER + "Moon.obj";
 const string EARTH_OBJ_FILE_PATH = ASSETS_FOLDER + "Earth.obj";
 
+// Tempo, em segundos, que a Lua leva para percorrer a curva inteira
+const float ORBIT_PERIOD = 20.0f;
+
 struct Geometry
 {
   GLuint VAO;
   int verticesCount;
+  float boundingRadius; // Raio da esfera envolvente, centrada na origem do modelo
+};
+
+// Dados que a thread da OpenGL entrega à simulação de um frame
+struct SimulationInput
+{
+  float time;
+  float deltaTime;
+  int viewCount;
+  glm::vec4 frustumPlanes[2][FRUSTUM_PLANE_COUNT];
+  glm::mat4 viewProjections[2]; // Para rasterizar os oclusores de cada view
+  bool occlusionCulling;
+  glm::mat4 *models; // Instance buffer mapeado pela thread da OpenGL, só escrito pela simulação
+  bool pick; // Raio da tecla X, testado contra a BVH dos objetos
+  glm::vec3 pickOrigin, pickDirection;
+};
+
+// Objetos da cena, na ordem dos arrays do snapshot
+enum SceneObject
+{
+  MOON,
+  EARTH,
+  OBJECT_COUNT
+};
+
+// Passos da fila de draws, na ordem em que são executados
+enum RenderPass
+{
+  PASS_DEPTH,
+  PASS_COLOR
+};
+
+// Tudo o que a thread da OpenGL precisa para desenhar um frame, calculado pela simulação
+// (as matrizes model vão direto para o instance buffer)
+struct SceneSnapshot
+{
+  bool visible[2][OBJECT_COUNT];
+  int occluded[2]; // Objetos dentro do frustum de cada view mas atrás dos oclusores
+  glm::vec3 centers[OBJECT_COUNT]; // Posição de cada objeto, para ordenar os draws pela distância
+  bool picked; // O frame tinha um raio da tecla X: pickedObject (-1 se nenhum), o triângulo e a distância
+  int pickedObject;
+  int pickedTriangle;
+  float pickDistance;
 };
 
 Geometry setupGeometry(const std::vector<float> &vertices);
+std::vector<float> buildLods(Mesh &mesh, const std::vector<float> &vertices, const char *name);
 vector <glm::vec3> generateControlPointsSet(string path);
+void attachInstances(InstanceBuffer &instances, Mesh *const *meshes);
+void printShaderLoadTimes(const vector<const Shader *> &shaders);
 
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 1000, HEIGHT = 1000;
 
 Camera camera;
+Camera topCamera; // Vista de cima da órbita, usada na tela dividida
+FrameClock frameClock;
+Profiler profiler;
+bool showOrbit = false;
+bool showProfiler = false;
+bool splitScreen = false;
+bool deferredShading = false;
+bool depthPrepass = false;
+bool pickRequested = false;
+bool occlusionCulling = true;
+ReplayRecorder recorder;
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode)
 {
-  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+  recorder.key(key, action);
+
+  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS && window)
     glfwSetWindowShouldClose(window, GL_TRUE);
 
+  if (key == GLFW_KEY_C && action == GLFW_PRESS)
+    showOrbit = !showOrbit;
+
+  if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    frameClock.setPaused(!frameClock.isPaused());
+
+  if (key == GLFW_KEY_V && action == GLFW_PRESS)
+    splitScreen = !splitScreen;
+
+  if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    deferredShading = !deferredShading;
+
+  if (key == GLFW_KEY_Z && action == GLFW_PRESS)
+    depthPrepass = !depthPrepass;
+
+  if (key == GLFW_KEY_X && action == GLFW_PRESS)
+    pickRequested = true;
+
+  if (key == GLFW_KEY_H && action == GLFW_PRESS)
+    occlusionCulling = !occlusionCulling;
+
+  if (key == GLFW_KEY_O && action == GLFW_PRESS)
+  {
+    showProfiler = !showProfiler;
+
+    if (!showProfiler && window)
+      glfwSetWindowTitle(window, "3D Cubes");
+  }
+
+#if GL_STATS_ENABLED
+  // Mostra no console os contadores de chamadas OpenGL (mín/média/máx dos últimos frames)
+  if (key == GLFW_KEY_G && action == GLFW_PRESS)
+    cout << GLStats::instance().getSummary() << endl;
+#endif
+
   camera.move(window, key, action);
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
+	recorder.mouse(xpos, ypos);
 	camera.rotate(window, xpos, ypos);
 }
 
-int main()
+int main(int argc, char **argv)
 {
-  glfwInit();
+  RunOptions options = parseRunOptions(argc, argv);
+  GLFWwindow *window = nullptr;
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  // Só calcula a precisão de profundidade das projeções, sem abrir contexto OpenGL
+  if (options.depthReport)
+    return runDepthPrecisionReport() ? 0 : 1;
+
+  if (options.jobBenchmark > 0)
+  {
+    runJobBenchmark(options.jobBenchmark);
+    return 0;
+  }
 
-  // Criação da janela GLFW
-  GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "3D Cubes", nullptr, nullptr);
-  glfwMakeContextCurrent(window);
+  if (options.sceneBenchmark > 0)
+  {
+    runSceneBenchmark(options.sceneBenchmark);
+    return 0;
+  }
 
-  // Fazendo o registro da função de callback para a janela GLFW
-  glfwSetKeyCallback(window, key_callback);
-  glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  if (options.lightBenchmark)
+  {
+    runLightBenchmark();
+    return 0;
+  }
 
-  // GLAD: carrega todos os ponteiros d funções da OpenGL
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  if (options.sortBenchmark > 0)
   {
-    std::cout << "Failed to initialize GLAD" << std::endl;
+    runSortBenchmark(options.sortBenchmark);
+    return 0;
+  }
+
+  if (options.bvhBenchmark > 0)
+  {
+    runBvhBenchmark(options.bvhBenchmark);
+    return 0;
+  }
+
+  if (options.rayBenchmark)
+  {
+    runRayBenchmark({MOON_OBJ_FILE_PATH, EARTH_OBJ_FILE_PATH, "../common/3d-models/suzanne/SuzanneTriTextured.obj"});
+    return 0;
+  }
+
+  if (options.occlusionBenchmark > 0)
+  {
+    runOcclusionBenchmark(EARTH_OBJ_FILE_PATH, options.occlusionBenchmark);
+    return 0;
+  }
+
+  if (options.animationBenchmark > 0)
+  {
+    runAnimationBenchmark(options.animationBenchmark);
+    return 0;
+  }
+
+  if (options.headless)
+  {
+    // Sem janela nem mouse: renderiza em um FBO e reproduz um script de entrada
+    if (!createHeadlessContext())
+    {
+      std::cout << "Failed to create headless context" << std::endl;
+      return 1;
+    }
+  }
+  else
+  {
+    glfwInit();
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // Criação da janela GLFW
+    window = glfwCreateWindow(WIDTH, HEIGHT, "3D Cubes", nullptr, nullptr);
+    glfwMakeContextCurrent(window);
+
+    // Fazendo o registro da função de callback para a janela GLFW
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetCursorPos(window, WIDTH / 2, HEIGHT / 2);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // GLAD: carrega todos os ponteiros d funções da OpenGL
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+      std::cout << "Failed to initialize GLAD" << std::endl;
+    }
   }
 
   // Obtendo as informações de versão
@@ -91,16 +286,97 @@ int main()
   cout << "Renderer: " << renderer << endl;
   cout << "OpenGL version supported " << version << endl;
 
+  // Os envios da curva editada precisam de um contexto, então este benchmark roda depois dele
+  if (options.curveBenchmark)
+  {
+    runCurveBenchmark();
+    return 0;
+  }
+
   // Definindo as dimensões da viewport com as mesmas dimensões da janela da aplicação
-  int width, height;
-  glfwGetFramebufferSize(window, &width, &height);
+  int width = WIDTH, height = HEIGHT;
+  OffscreenTarget offscreenTarget;
+
+  if (!options.headless)
+  {
+    glfwGetFramebufferSize(window, &width, &height);
+  }
+
+  // Reverse-Z precisa de um depth buffer em float, então na janela a cena também é
+  // desenhada em um FBO e copiada para o framebuffer padrão a cada frame
+  bool useOffscreenTarget = options.headless || options.reverseZ;
+
+  if (useOffscreenTarget)
+  {
+    offscreenTarget = createOffscreenTarget(width, height, options.reverseZ ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24);
+  }
+
   glViewport(0, 0, width, height);
 
-  Shader shader("./shaders/vertex-shader.vert", "./shaders/fragment-shader.frag");
+  // Os programas já linkados ficam em disco: nas execuções seguintes não há compilação de GLSL
+  Shader::setBinaryCacheDirectory(options.shaderCachePath);
 
-  glUseProgram(shader.ID);
+  // Um slot por view: 0 é a câmera principal e 1 a vista de cima
+  ViewUniforms views;
+  views.initialize(2);
 
-  camera.initialize(&shader, width, height);
+  // Luzes pontuais em órbita (--lights N), agrupadas nos froxels de cada view a cada frame
+  vector<PointLight> pointLights = createOrbitLights(options.lights);
+  bool clusteredLighting = !pointLights.empty();
+  LightClusters clusters[2];
+
+  if (clusteredLighting)
+  {
+    clusters[0].initialize();
+    clusters[1].initialize();
+  }
+
+  // Cada material usa a variante mais barata do shader da cena que atende às suas entradas;
+  // as variantes são compiladas na primeira vez em que são pedidas
+  ShaderPermutations sceneShaders;
+  sceneShaders.initialize("./shaders/vertex-shader.vert", "./shaders/fragment-shader.frag", [&](Shader &variant, unsigned int features)
+  {
+    views.attach(variant);
+
+    if (features & SHADER_CLUSTERED)
+      clusters[0].attach(variant);
+
+    // Definindo as propriedades da fonte de luz
+    variant.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
+    variant.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+  });
+
+  // As câmeras não escrevem em nenhum shader, suas matrizes são publicadas no uniform buffer das views
+  camera.initialize(nullptr, width, height);
+  topCamera.initialize(nullptr, width / 2, height, 0.05f, -90.0f, -90.0f, glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 6.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+  topCamera.setPerspective(45.0f, 1.0f, 20.0f);
+
+  // Caminho deferred (--deferred ou tecla F): G-buffer, luzes somadas uma vez por pixel visível
+  // (com os mesmos froxels do forward) e composição
+  Shader lightingShader("./shaders/fullscreen.vert", "./shaders/deferred-lighting.frag", clusteredLighting ? ShaderPermutations::getDefines(SHADER_CLUSTERED) : "");
+  Shader compositeShader("./shaders/fullscreen.vert", "./shaders/deferred-composite.frag");
+  DeferredRenderer deferred;
+  deferred.initialize(width, height, &lightingShader, &compositeShader);
+  views.attach(lightingShader);
+  lightingShader.Use();
+  lightingShader.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
+  lightingShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+
+  if (clusteredLighting)
+    clusters[0].attach(lightingShader);
+
+  deferredShading = options.deferred;
+  depthPrepass = options.depthPrepass;
+  occlusionCulling = options.occlusionCulling;
+
+  if (options.reverseZ)
+  {
+    // O deferred reconstrói a posição a partir da profundidade, então precisa saber como ela é gravada
+    bool clipControl = enableReverseZ(options.headless ? getHeadlessProcLoader() : (GLADloadproc)glfwGetProcAddress);
+    deferred.setZeroToOneDepth(clipControl);
+    camera.setReverseZ(true);
+    topCamera.setReverseZ(true);
+  }
 
   ParsedObj parsedMoonObj = parseOBJFile(MOON_OBJ_FILE_PATH);
   vector<Material> moonMaterials = readMTLFile(ASSETS_FOLDER, parsedMoonObj.mtlFileName);
@@ -110,9 +386,13 @@ int main()
   GLuint MOON_VAO = moonGeometry.VAO;
   int moonVerticesCount = moonGeometry.verticesCount;
 
+  unsigned int sharedFeatures = SHADER_INSTANCED | (clusteredLighting ? SHADER_CLUSTERED : 0);
+  Shader *moonShader = sceneShaders.get(ShaderPermutations::selectFeatures(moonMaterial) | sharedFeatures);
+  Shader *moonGBufferShader = sceneShaders.get(ShaderPermutations::selectFeatures(moonMaterial) | SHADER_INSTANCED | SHADER_DEFERRED);
+
   Mesh moon;
-  moon.initialize(MOON_VAO, moonVerticesCount, &shader, moonTextureId, glm::vec3(-1.0f,0.0f,0.0f), glm::vec3(0.1f,0.1f,0.1f));
-  moon.setShouldRotateY(true);
+  moon.initialize(MOON_VAO, moonVerticesCount, moonShader, moonTextureId);
+  vector<float> moonOccluder = buildLods(moon, parsedMoonObj.vertices, "moon");
 
   ParsedObj parsedEarthObj = parseOBJFile(EARTH_OBJ_FILE_PATH);
   vector<Material> earthMaterials = readMTLFile(ASSETS_FOLDER, parsedEarthObj.mtlFileName);
@@ -122,30 +402,242 @@ int main()
   GLuint EARTH_VAO = earthGeometry.VAO;
   int earthVerticesCount = earthGeometry.verticesCount;
 
+  Shader *earthShader = sceneShaders.get(ShaderPermutations::selectFeatures(earthMaterial) | sharedFeatures);
+  Shader *earthGBufferShader = sceneShaders.get(ShaderPermutations::selectFeatures(earthMaterial) | SHADER_INSTANCED | SHADER_DEFERRED);
+
   Mesh earth;
-  earth.initialize(EARTH_VAO, earthVerticesCount, &shader, earthTextureId, glm::vec3(0.0f,0.0f,0.0f), glm::vec3(0.15f,0.15f,0.15f));
-  earth.setShouldRotateY(true);
+  earth.initialize(EARTH_VAO, earthVerticesCount, earthShader, earthTextureId);
+  vector<float> earthOccluder = buildLods(earth, parsedEarthObj.vertices, "earth");
+
+  // A Terra e a Lua são filhas do centro do sistema: a órbita da Lua é relativa a ele,
+  // e mover ou girar o sistema leva os dois juntos
+  SceneGraph scene;
+  int earthSystem = scene.createNode();
+  int nodes[OBJECT_COUNT];
+  nodes[MOON] = scene.createNode(earthSystem, glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.1f, 0.1f, 0.1f));
+  nodes[EARTH] = scene.createNode(earthSystem, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.15f, 0.15f, 0.15f));
+  const float ROTATION_SPEED = 0.06f; // Radianos por segundo, em torno do eixo y
 
-  // Definindo as propriedades da fonte de luz
-  shader.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
-  shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+  // As matrizes model são escritas pela simulação direto em um buffer mapeado e lidas como atributo por instância
+  InstanceBuffer instances;
+  instances.initialize(OBJECT_COUNT);
 
   std::vector<glm::vec3> controlPoints = generateControlPointsSet("config");
 
   Bezier bezier;
 	bezier.setControlPoints(controlPoints);
-	bezier.setShader(&shader);
-	bezier.generateCurve(100);
-	int nbCurvePoints = bezier.getNbCurvePoints();
-	int curentPointOnCurve = 0;
+
+  // A órbita é desenhada na GPU a partir dos pontos de controle, sem gerar a curva na CPU
+  Shader curveShader("./shaders/curve-batch.vert", "./shaders/curve.frag");
+  // O pré-passo de profundidade usa a variante mais simples: sem textura nem iluminação
+  Shader *depthOnlyShader = sceneShaders.get(SHADER_INSTANCED);
+
+  printShaderLoadTimes({moonShader, earthShader, moonGBufferShader, earthGBufferShader, depthOnlyShader, &lightingShader, &compositeShader, &curveShader});
+  cout << "Shader variants: moon " << ShaderPermutations::getName(ShaderPermutations::selectFeatures(moonMaterial))
+       << ", earth " << ShaderPermutations::getName(ShaderPermutations::selectFeatures(earthMaterial)) << endl;
+  CurveBatch orbit;
+  orbit.initialize(&curveShader, bezier, controlPoints.size(), 100, 1);
+  orbit.addCurve(controlPoints);
+  views.attach(curveShader);
 
   glEnable(GL_DEPTH_TEST);
 
+  // Depois do pré-passo a cena é desenhada só onde a profundidade é igual à já gravada
+  GLint sceneDepthFunc;
+  glGetIntegerv(GL_DEPTH_FUNC, &sceneDepthFunc);
+  GLenum equalDepthFunc = sceneDepthFunc == GL_GREATER ? GL_GEQUAL : GL_LEQUAL;
+
+  // A simulação (órbita, rotação e culling) roda em outra thread e escreve em um snapshot
+  // duplo: enquanto ela calcula o frame N, esta thread desenha o frame N-1
+  Mesh *meshes[OBJECT_COUNT] = {&moon, &earth};
+  Shader *forwardShaders[OBJECT_COUNT] = {moonShader, earthShader};
+  Shader *gBufferShaders[OBJECT_COUNT] = {moonGBufferShader, earthGBufferShader};
+  Material *materials[OBJECT_COUNT] = {&moonMaterial, &earthMaterial};
+  const char *drawScopes[OBJECT_COUNT] = {"moon.draw", "earth.draw"};
+  float radii[OBJECT_COUNT] = {moonGeometry.boundingRadius * 0.1f, earthGeometry.boundingRadius * 0.15f};
+  const char *objectNames[OBJECT_COUNT] = {"moon", "earth"};
+
+  // BVH dos triângulos de cada malha, para o raio da tecla X acertar a superfície e não a esfera envolvente
+  TriangleBvh triangleBvhs[OBJECT_COUNT];
+  const vector<float> *objectVertices[OBJECT_COUNT] = {&parsedMoonObj.vertices, &parsedEarthObj.vertices};
+  for (int i = 0; i < OBJECT_COUNT; i++)
+  {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    triangleBvhs[i].build(*objectVertices[i]);
+    cout << "Triangle BVH " << objectNames[i] << ": " << triangleBvhs[i].getTriangleCount() << " triangles, " << triangleBvhs[i].getNodeCount()
+         << " nodes (" << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms)" << endl;
+  }
+
+  // Fila dos draws opacos, refeita a cada view
+  RenderQueue renderQueue;
+
+  // Quantas vezes cada nível de detalhe foi desenhado, mostrado no fim do modo headless
+  vector<vector<int>> lodDraws(OBJECT_COUNT);
+  for (int i = 0; i < OBJECT_COUNT; i++)
+    lodDraws[i].assign(meshes[i]->getLodCount(), 0);
+  // Draws feitos e os que o culling por oclusão evitou, também mostrados no fim
+  int objectDraws = 0, occludedDraws = 0;
+
+  // O trabalho por objeto (matrizes model e centros) é dividido entre os núcleos pelo job system
+  JobSystem jobs;
+  jobs.initialize();
+
+  // Caixas das esferas envolventes: a BVH é construída no primeiro frame e depois só
+  // reajustada, já que a Lua se move pela curva mas a cena não muda
+  Bvh objectBvh;
+  glm::vec3 boundsMin[OBJECT_COUNT], boundsMax[OBJECT_COUNT];
+  vector<int> candidates;
+
+  // Depois do frustum, os objetos visíveis de cada view são rasterizados na pirâmide de profundidade
+  // pelo seu nível de detalhe mais simples, e os que ficam atrás deles não são desenhados
+  OcclusionCuller occlusion;
+  const vector<float> *occluders[OBJECT_COUNT] = {&moonOccluder, &earthOccluder};
+
+  SimulationThread<SimulationInput, SceneSnapshot> simulation;
+  simulation.start([&](const SimulationInput &input, SceneSnapshot &snapshot)
+  {
+    scene.setPosition(nodes[MOON], bezier.evaluate(input.time / ORBIT_PERIOD));
+
+    for (int i = 0; i < OBJECT_COUNT; i++)
+      scene.rotate(nodes[i], ROTATION_SPEED * input.deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Só os nós alterados (e os seus descendentes) são recalculados
+    scene.updateWorld();
+
+    jobs.parallelFor(OBJECT_COUNT, 1, [&](int begin, int end)
+    {
+      for (int i = begin; i < end; i++)
+      {
+        input.models[i] = scene.getWorldMatrix(nodes[i]);
+
+        glm::vec3 center = scene.getWorldPosition(nodes[i]);
+        snapshot.centers[i] = center;
+        boundsMin[i] = center - glm::vec3(radii[i]);
+        boundsMax[i] = center + glm::vec3(radii[i]);
+      }
+    });
+
+    if (objectBvh.getItemCount() == 0)
+      objectBvh.build(boundsMin, boundsMax, OBJECT_COUNT);
+    else
+      objectBvh.refit(boundsMin, boundsMax);
+
+    // A BVH descarta as caixas fora do frustum, e as que sobram passam pelo teste da esfera
+    for (int view = 0; view < input.viewCount; view++)
+    {
+      candidates.clear();
+      objectBvh.queryFrustum(input.frustumPlanes[view], candidates);
+
+      std::fill(snapshot.visible[view], snapshot.visible[view] + OBJECT_COUNT, false);
+      for (size_t c = 0; c < candidates.size(); c++)
+      {
+        int i = candidates[c];
+        snapshot.visible[view][i] = Camera::isSphereInFrustum(input.frustumPlanes[view], snapshot.centers[i], radii[i]);
+      }
+
+      snapshot.occluded[view] = 0;
+      if (input.occlusionCulling)
+      {
+        occlusion.begin(input.viewProjections[view]);
+        for (int i = 0; i < OBJECT_COUNT; i++)
+          if (snapshot.visible[view][i])
+            occlusion.addOccluder(*occluders[i], scene.getWorldMatrix(nodes[i]));
+        occlusion.buildPyramid();
+
+        // A esfera de um objeto está sempre na frente do seu próprio oclusor, então ele não se esconde
+        for (int i = 0; i < OBJECT_COUNT; i++)
+          if (snapshot.visible[view][i] && occlusion.isSphereOccluded(snapshot.centers[i], radii[i]))
+          {
+            snapshot.visible[view][i] = false;
+            snapshot.occluded[view]++;
+          }
+      }
+    }
+
+    snapshot.picked = input.pick;
+    if (input.pick)
+    {
+      // As esferas acertadas passam o raio para o espaço do modelo, onde está a BVH dos triângulos. A direção
+      // não é normalizada, então a distância ao longo dela continua sendo a do mundo
+      snapshot.pickedObject = objectBvh.raycast(input.pickOrigin, input.pickDirection, FLT_MAX, snapshot.pickDistance,
+                                                [&](int item, float maxDistance)
+                                                {
+                                                  if (Bvh::intersectSphere(snapshot.centers[item], radii[item], input.pickOrigin, input.pickDirection, maxDistance) < 0.0f)
+                                                    return -1.0f;
+
+                                                  glm::mat4 worldToModel = glm::inverse(scene.getWorldMatrix(nodes[item]));
+                                                  glm::vec3 origin = glm::vec3(worldToModel * glm::vec4(input.pickOrigin, 1.0f));
+                                                  glm::vec3 direction = glm::vec3(worldToModel * glm::vec4(input.pickDirection, 0.0f));
+                                                  RayHit hit;
+                                                  if (!triangleBvhs[item].raycast(origin, direction, maxDistance, hit))
+                                                    return -1.0f;
+                                                  // Cada acerto aceito é mais próximo que os anteriores, então o último é o do objeto escolhido
+                                                  snapshot.pickedTriangle = hit.triangle;
+                                                  return hit.distance;
+                                                });
+    }
+  });
+
+  const SceneSnapshot *snapshot = nullptr;
+
+  // No modo headless o tempo avança sempre o mesmo passo por frame, tornando o replay determinístico
+  vector<ReplayEvent> replayEvents;
+  size_t nextReplayEvent = 0;
+  FrameTimings frameTimings;
+  int frame = 0;
+
+  profiler.initialize();
+  profiler.setRecording(!options.tracePath.empty());
+  showProfiler = options.overlay;
+
+  if (options.headless)
+  {
+    frameClock.setFixedDelta(options.fixedStep);
+    frameTimings.initialize(options.frames);
+
+    if (!options.replayPath.empty())
+      replayEvents = loadReplayScript(options.replayPath);
+  }
+
+  // Grava os eventos dos callbacks (do teclado e mouse, ou do replay no headless) no mesmo formato do --replay
+  if (!options.recordPath.empty())
+    recorder.open(options.recordPath);
+
   // Loop da aplicação - "game loop"
-  while (!glfwWindowShouldClose(window))
+  while (options.headless ? frame < options.frames : !glfwWindowShouldClose(window))
   {
-    // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-    glfwPollEvents();
+    recorder.setFrame(frame);
+
+    if (options.headless)
+    {
+      // Aplica os eventos gravados para este frame, como se viessem dos callbacks
+      for (; nextReplayEvent < replayEvents.size() && replayEvents[nextReplayEvent].frame <= frame; nextReplayEvent++)
+      {
+        const ReplayEvent &event = replayEvents[nextReplayEvent];
+
+        if (event.isKey)
+          key_callback(window, event.key, 0, event.action, 0);
+        else
+          mouse_callback(window, event.x, event.y);
+      }
+
+      frameTimings.beginFrame(frame);
+    }
+    else
+    {
+      // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
+      glfwPollEvents();
+
+      // O movimento vem do estado das teclas no frame; no headless ele vem dos eventos do replay
+      camera.pollKeys(window);
+    }
+
+    profiler.beginFrame();
+
+    // Todas as animações avançam pelo tempo do frame, e não por frame desenhado
+    frameClock.tick();
+    float deltaTime = frameClock.getDeltaTime();
+    recorder.addTime(frameClock.getRealDeltaTime());
 
     // Limpa o buffer de cor
     glClearColor(0.08f, 0.08f, 0.08f, 1.0f); // cor de fundo
@@ -154,25 +646,272 @@ int main()
     glLineWidth(10);
     glPointSize(20);
 
-    camera.update();
+    {
+      ProfileScope scope(profiler, "camera.update");
+      camera.resize(splitScreen ? width / 2 : width, height);
+      camera.update(frameClock.getRealDeltaTime());
+      topCamera.update(0.0f);
+      views.update(0, camera);
+      views.update(1, topCamera);
+    }
+
+    // Entrega o frame atual para a simulação; no primeiro frame ainda não há snapshot anterior para desenhar
+    SimulationInput simulationInput;
+    simulationInput.time = frameClock.getTime();
+    simulationInput.deltaTime = deltaTime;
+    simulationInput.viewCount = 2;
+    std::copy(camera.getFrustumPlanes(), camera.getFrustumPlanes() + FRUSTUM_PLANE_COUNT, simulationInput.frustumPlanes[0]);
+    std::copy(topCamera.getFrustumPlanes(), topCamera.getFrustumPlanes() + FRUSTUM_PLANE_COUNT, simulationInput.frustumPlanes[1]);
+    simulationInput.viewProjections[0] = camera.getViewProjectionMatrix();
+    simulationInput.viewProjections[1] = topCamera.getViewProjectionMatrix();
+    simulationInput.occlusionCulling = occlusionCulling;
+    simulationInput.models = instances.map();
+
+    // O raio sai da câmera principal pelo centro da sua view (a mira, já que o cursor fica escondido)
+    simulationInput.pick = pickRequested;
+    if (pickRequested)
+    {
+      int mainViewWidth = splitScreen ? width / 2 : width;
+      camera.getRay(mainViewWidth * 0.5f, height * 0.5f, mainViewWidth, height, simulationInput.pickOrigin, simulationInput.pickDirection);
+      pickRequested = false;
+    }
+    simulation.submit(simulationInput);
+
+    if (!snapshot)
+    {
+      snapshot = &simulation.wait();
+      attachInstances(instances, meshes);
+    }
+
+    if (snapshot->picked)
+    {
+      if (snapshot->pickedObject >= 0)
+        cout << "Picked: " << objectNames[snapshot->pickedObject] << " triangle " << snapshot->pickedTriangle << " at " << snapshot->pickDistance << endl;
+      else
+        cout << "Picked: nothing" << endl;
+    }
+
+    // Cada view desenha a cena na sua parte da tela lendo o seu slot do uniform buffer
+    int viewCount = splitScreen ? 2 : 1;
+    int viewWidth = width / viewCount;
+
+    // Os dois caminhos desenham a mesma cena, cada objeto com a variante do caminho ativo (tecla F)
+    for (int i = 0; i < OBJECT_COUNT; i++)
+      meshes[i]->setShader(deferredShading ? gBufferShaders[i] : forwardShaders[i]);
+
+    if (clusteredLighting)
+    {
+      ProfileScope scope(profiler, "lights.bin");
+      updateOrbitLights(pointLights, frameClock.getTime());
+
+      for (int view = 0; view < viewCount; view++)
+      {
+        clusters[view].build(view == 0 ? camera : topCamera, pointLights);
+        clusters[view].upload(glm::vec4(view * viewWidth, 0, viewWidth, height));
+      }
+    }
+
+    for (int view = 0; view < viewCount; view++)
+    {
+      glm::vec4 viewport(view * viewWidth, 0, viewWidth, height);
+      glViewport(view * viewWidth, 0, viewWidth, height);
+      views.bind(view);
+
+      if (clusteredLighting)
+        clusters[view].bind();
+
+      if (deferredShading)
+        deferred.beginGeometry();
+
+      // Cada objeto visível envia os seus draws: profundidade (com o pré-passo) e cor. Sem o
+      // pré-passo a cor vai do mais próximo para o mais distante (pela superfície da esfera
+      // envolvente); com ele a profundidade já está resolvida e a cor é agrupada por estado
+      const Camera &viewCamera = view == 0 ? camera : topCamera;
+      renderQueue.clear();
+      occludedDraws += snapshot->occluded[view];
+
+      for (int i = 0; i < OBJECT_COUNT; i++)
+      {
+        if (snapshot->visible[view][i])
+        {
+          // O nível de detalhe vem do tamanho do objeto nesta view (ou da opção --lod)
+          if (options.forcedLod >= 0)
+            meshes[i]->setLod(min(options.forcedLod, meshes[i]->getLodCount() - 1));
+          else
+            meshes[i]->selectLod(viewCamera.getProjectedDiameter(snapshot->centers[i], radii[i], height), view);
+          lodDraws[i][meshes[i]->getLod()]++;
+          objectDraws++;
+
+          RenderItem item;
+          item.depth = -(viewCamera.getViewMatrix() * glm::vec4(snapshot->centers[i], 1.0f)).z - radii[i];
+          item.vertexArray = meshes[i]->getVAO();
+          item.payload = i;
+
+          if (depthPrepass)
+          {
+            item.pass = PASS_DEPTH;
+            item.program = depthOnlyShader->ID;
+            item.material = 0;
+            item.texture = 0;
+            renderQueue.push(item, RenderQueue::FRONT_TO_BACK);
+          }
+
+          item.pass = PASS_COLOR;
+          item.program = meshes[i]->getShader()->ID;
+          item.material = i + 1;
+          item.texture = meshes[i]->getTextureID();
+          renderQueue.push(item, depthPrepass ? RenderQueue::BY_STATE : RenderQueue::FRONT_TO_BACK);
+        }
+      }
 
-		glm::vec3 pointOnCurve = bezier.getPointOnCurve(curentPointOnCurve);
-		moon.updatePosition(pointOnCurve);
-    
-		moon.update();
-		moon.draw(moonMaterial);
+      renderQueue.sort();
 
-    earth.update();
-		earth.draw(earthMaterial);
+      // Só o estado que mudou desde o draw anterior é ligado
+      renderQueue.execute([&](const RenderItem &item, unsigned int changes)
+      {
+        Mesh *mesh = meshes[item.payload];
+        bool depthOnly = item.pass == PASS_DEPTH;
 
-    curentPointOnCurve = (curentPointOnCurve + 1) % nbCurvePoints;
+        // O pré-passo só grava profundidade, e depois dele a cor é desenhada onde ela é igual
+        if (changes & (1u << STATE_PASS))
+        {
+          GLboolean writeColor = depthOnly ? GL_FALSE : GL_TRUE;
+          glColorMask(writeColor, writeColor, writeColor, writeColor);
+          glDepthFunc(depthPrepass && !depthOnly ? equalDepthFunc : sceneDepthFunc);
+          glDepthMask(depthPrepass && !depthOnly ? GL_FALSE : GL_TRUE);
+        }
 
-    glfwSwapBuffers(window);
+        if (changes & (1u << STATE_PROGRAM))
+          (depthOnly ? depthOnlyShader : mesh->getShader())->Use();
+
+        // O pré-passo não usa material nem textura (ids 0), então eles nunca mudam nele
+        if (changes & (1u << STATE_MATERIAL))
+          mesh->setMaterialUniforms(*materials[item.payload]);
+
+        if (changes & (1u << STATE_TEXTURE))
+          mesh->bindTexture();
+
+        if (changes & (1u << STATE_VERTEX_ARRAY))
+          mesh->bindVertexArray();
+
+        ProfileScope scope(profiler, depthOnly ? "depth.prepass" : drawScopes[item.payload], true);
+        mesh->drawBoundInstances(1);
+      });
+
+      glBindVertexArray(0);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+      glDepthMask(GL_TRUE);
+      glDepthFunc(sceneDepthFunc);
+
+      if (deferredShading)
+      {
+        {
+          ProfileScope scope(profiler, "deferred.lights", true);
+          deferred.accumulateLights(viewCamera, viewport);
+        }
+
+        {
+          ProfileScope scope(profiler, "deferred.composite", true);
+          deferred.composite();
+        }
+      }
+
+      if (showOrbit)
+      {
+        ProfileScope scope(profiler, "orbit.draw", true);
+        orbit.drawCurves(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+      }
+    }
+
+    glViewport(0, 0, width, height);
+
+    if (showProfiler)
+    {
+      profiler.drawOverlay(width, height);
+
+      // O texto com os tempos vai para o título da janela, atualizado a cada 30 frames
+      if (window && frameClock.getFrameIndex() % 30 == 0)
+        glfwSetWindowTitle(window, profiler.getSummary().c_str());
+    }
+
+    profiler.endFrame();
+    GL_STATS_END_FRAME();
+
+    if (options.headless)
+    {
+      frameTimings.endFrame(frame);
+
+      if (!options.capturePath.empty())
+        captureFrame(offscreenTarget, options.capturePath, frame);
+    }
+    else
+    {
+      if (useOffscreenTarget)
+      {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreenTarget.FBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenTarget.FBO);
+      }
+
+      glfwSwapBuffers(window);
+    }
+
+    // A simulação do frame atual rodou em paralelo com o desenho e a troca de buffers
+    if (simulation.hasPending())
+    {
+      ProfileScope scope(profiler, "simulation.wait");
+      snapshot = &simulation.wait();
+      attachInstances(instances, meshes);
+    }
+
+    frame++;
   }
 
+  if (!options.tracePath.empty())
+    profiler.saveChromeTrace(options.tracePath);
+  recorder.close(frame);
+
+  simulation.stop();
+  jobs.shutdown();
+  profiler.release();
+  views.release();
+  instances.release();
+  sceneShaders.release();
+  clusters[0].release();
+  clusters[1].release();
+  deferred.release();
+
+  if (options.headless)
+  {
+    frameTimings.save(options.timingsPath, frame);
+
+    for (int i = 0; i < OBJECT_COUNT; i++)
+    {
+      cout << "LOD draws " << (i == MOON ? "moon" : "earth") << ":";
+      for (size_t lod = 0; lod < lodDraws[i].size(); lod++)
+        cout << " " << lod << "=" << lodDraws[i][lod];
+      cout << endl;
+    }
+    cout << "Occlusion culling: " << occludedDraws << " of " << objectDraws + occludedDraws << " draws culled" << endl;
+
+#if GL_STATS_ENABLED
+    cout << GLStats::instance().getSummary();
+#endif
+  }
 
-  glDeleteVertexArrays(1, &MOON_VAO);
-  glDeleteVertexArrays(1, &EARTH_VAO);
+  if (useOffscreenTarget)
+  {
+    deleteOffscreenTarget(offscreenTarget);
+  }
+
+  // O nível 0 de cada malha é o MOON_VAO / EARTH_VAO
+  for (int i = 0; i < OBJECT_COUNT; i++)
+    for (int lod = 0; lod < meshes[i]->getLodCount(); lod++)
+      glDeleteVertexArrays(1, &meshes[i]->getLodLevel(lod).VAO);
+  bezier.release();
+  orbit.release();
   glfwTerminate();
   return 0;
 }
@@ -223,9 +962,68 @@ Geometry setupGeometry(const std::vector<float> &vertices)
   // Dividimos por 11 pois cada vértice tem 11 floats (3 coordenadas + 3 cores + 2 texturas + 3 normais)
   int verticesCount = vertices.size() / 11;
 
+  float boundingRadius = 0.0f;
+  for (int i = 0; i < verticesCount; i++)
+    boundingRadius = max(boundingRadius, glm::length(glm::vec3(vertices[i * 11], vertices[i * 11 + 1], vertices[i * 11 + 2])));
+
   return {
       VAO,
       verticesCount,
+      boundingRadius,
   };
 }
 
+// Gera os níveis de detalhe de uma malha do OBJ, cada um com metade dos triângulos do
+// anterior. O nível 1 é usado abaixo de LOD_SCREEN_SIZES[1] pixels de diâmetro na tela, e
+// cada nível seguinte quando o diâmetro cai à metade (a área, e os pixels por triângulo, a um quarto).
+// Retorna os vértices do nível mais simples, o oclusor do objeto no culling por oclusão
+std::vector<float> buildLods(Mesh &mesh, const std::vector<float> &vertices, const char *name)
+{
+  const int LOD_COUNT = 4;
+  const float LOD_SCREEN_SIZES[LOD_COUNT] = {0.0f, 320.0f, 160.0f, 80.0f};
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  MeshSimplifier simplifier;
+  simplifier.initialize(vertices);
+  int triangles = simplifier.getTriangleCount();
+
+  cout << "LODs " << name << ": " << triangles;
+  for (int lod = 1; lod < LOD_COUNT; lod++)
+  {
+    // Cada nível continua os colapsos do anterior, então a cadeia sai de uma única simplificação
+    simplifier.simplify(triangles >> lod);
+    Geometry geometry = setupGeometry(simplifier.getVertices());
+    mesh.addLod(geometry.VAO, geometry.verticesCount, LOD_SCREEN_SIZES[lod]);
+    cout << ", " << simplifier.getTriangleCount();
+  }
+  cout << " triangles (" << simplifier.getLockedCount() << " seam vertices kept, max error " << simplifier.getMaxError()
+       << ", " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms)" << endl;
+  return simplifier.getVertices();
+}
+
+// Termina a escrita do frame que a simulação acabou de calcular e aponta o atributo
+// model de cada objeto para a sua matriz no buffer, em todos os níveis de detalhe
+void attachInstances(InstanceBuffer &instances, Mesh *const *meshes)
+{
+  instances.unmap();
+
+  for (int i = 0; i < OBJECT_COUNT; i++)
+    for (int lod = 0; lod < meshes[i]->getLodCount(); lod++)
+      instances.attach(meshes[i]->getLodLevel(lod).VAO, i);
+}
+
+// Tempo gasto criando os programas, para comparar a partida com e sem o cache de binários
+void printShaderLoadTimes(const vector<const Shader *> &shaders)
+{
+  double total = 0.0;
+  int cached = 0;
+
+  for (size_t i = 0; i < shaders.size(); i++)
+  {
+    total += shaders[i]->getLoadMilliseconds();
+    cached += shaders[i]->isFromBinaryCache() ? 1 : 0;
+  }
+
+  cout << "Shaders: " << shaders.size() << " programs in " << total << " ms (" << cached << " from binary cache)" << endl;
+}
+
@@ -0,0 +1,39 @@
+#version 410
+
+// Pontos de controle de todas as curvas (vec3 em um texture buffer)
+uniform samplerBuffer controlPoints;
+
+// Declara as variáveis uniformes do shader
+uniform mat4 basis;
+uniform int controlPointsPerCurve;
+uniform int segmentStride;
+uniform int nSegments;
+uniform int pointsPerSegment;
+
+// Matrizes da view ativa, compartilhadas por todos os programas (ViewUniforms)
+layout (std140) uniform View
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+};
+
+void main()
+{
+    // Cada instância é uma curva e cada vértice é um ponto dessa curva
+    int segment = min(gl_VertexID / pointsPerSegment, nSegments - 1);
+    float t = float(gl_VertexID - segment * pointsPerSegment) / float(pointsPerSegment);
+
+    int first = gl_InstanceID * controlPointsPerCurve + segment * segmentStride;
+    vec3 P0 = texelFetch(controlPoints, first).xyz;
+    vec3 P1 = texelFetch(controlPoints, first + 1).xyz;
+    vec3 P2 = texelFetch(controlPoints, first + 2).xyz;
+    vec3 P3 = texelFetch(controlPoints, first + 3).xyz;
+
+    // p = G * M * T, igual à curva gerada na CPU
+    vec4 w = basis * vec4(t * t * t, t * t, t, 1.0);
+    vec3 p = w.x * P0 + w.y * P1 + w.z * P2 + w.w * P3;
+
+    gl_Position = viewProjection * vec4(p, 1.0);
+}
\ No newline at end of file
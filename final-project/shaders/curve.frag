@@ -0,0 +1,11 @@
+#version 410
+
+// Cor da curva
+uniform vec4 finalColor;
+
+out vec4 color;
+
+void main()
+{
+	color = finalColor;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 410
+
+// Composição do caminho deferred: copia as luzes somadas e a profundidade do
+// G-buffer para o framebuffer de saída
+
+uniform sampler2D gDepth;
+uniform sampler2D lightAccumulation;
+
+uniform float clearDepth; // Profundidade dos pixels sem geometria
+
+out vec4 color;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+
+	// Pixels sem geometria mantêm a cor de fundo
+	if (depth == clearDepth)
+		discard;
+
+	color = vec4(texelFetch(lightAccumulation, pixel, 0).rgb, 1.0);
+	gl_FragDepth = depth;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#version 410
+
+// Luzes do caminho deferred, calculadas a partir do G-buffer: ambiente, luz
+// principal e, com CLUSTERED, as luzes pontuais do froxel de cada pixel. Mesmo
+// resultado do fragment-shader.frag, mas uma vez por pixel visível. O triângulo
+// de tela inteira fica na profundidade do fundo, então o teste de profundidade
+// só deixa passar os pixels com geometria
+
+// G-buffer (DeferredRenderer)
+uniform sampler2D gAlbedo;   // Cor base, 1 se tem iluminação
+uniform sampler2D gNormal;   // Normal, expoente especular
+uniform sampler2D gAmbient;  // ka
+uniform sampler2D gDiffuse;  // kd
+uniform sampler2D gSpecular; // ks (zero nas variantes sem SPECULAR)
+uniform sampler2D gDepth;
+
+// Reconstrução da posição a partir da profundidade
+uniform mat4 inverseViewProjection;
+uniform vec4 viewport;   // Origem e tamanho da view, em pixels
+uniform vec2 depthToNdc; // Escala e bias da profundidade para o z em NDC
+
+uniform vec3 lightColor;
+uniform vec3 lightPosition;
+
+// Matrizes da view ativa, compartilhadas por todos os programas (ViewUniforms)
+layout (std140) uniform View
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+};
+
+out vec4 color;
+
+#ifdef CLUSTERED
+// Luzes pontuais, agrupadas por froxel na CPU (LightClusters)
+uniform samplerBuffer clusterLights;   // 2 texels por luz: posição + raio, cor
+uniform usamplerBuffer clusterRanges;  // Início e quantidade de luzes de cada froxel
+uniform usamplerBuffer clusterIndices; // Índices das luzes, agrupados por froxel
+
+layout (std140) uniform Clusters
+{
+    vec4 clusterGrid;     // Tiles em x e y, fatias em z, número de luzes
+    vec4 clusterDepth;    // Escala e bias da fatia, near e far
+    vec4 clusterViewport; // Origem da view e tamanho de um tile, em pixels
+};
+
+// Soma das luzes pontuais que alcançam o froxel deste pixel (veja fragment-shader.frag)
+vec3 clusteredLighting(vec3 fragmentPosition, vec3 N, vec3 albedo, vec3 ks, float q)
+{
+	float depth = -(view * vec4(fragmentPosition, 1.0)).z;
+	float slice = floor(log(max(depth, clusterDepth.z)) * clusterDepth.x + clusterDepth.y);
+	ivec3 cell = ivec3(ivec2((gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw), int(slice));
+	cell = clamp(cell, ivec3(0), ivec3(clusterGrid.xyz) - 1);
+	int cluster = (cell.z * int(clusterGrid.y) + cell.y) * int(clusterGrid.x) + cell.x;
+
+	uvec2 range = texelFetch(clusterRanges, cluster).xy;
+	vec3 V = normalize(cameraPos.xyz - fragmentPosition);
+	vec3 lighting = vec3(0.0);
+
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 pointColor = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		// Atenuação suave que chega a zero no raio da luz
+		vec3 toLight = positionRadius.xyz - fragmentPosition;
+		float distance2 = dot(toLight, toLight);
+		float falloff = clamp(1.0 - distance2 / (positionRadius.w * positionRadius.w), 0.0, 1.0);
+		falloff *= falloff;
+
+		vec3 L = toLight * inversesqrt(max(distance2, 1e-8));
+		lighting += albedo * max(dot(N, L), 0.0) * pointColor * falloff;
+
+		if (any(greaterThan(ks, vec3(0.0))))
+		{
+			vec3 R = reflect(-L, N);
+			lighting += ks * pow(max(dot(R, V), 0.0), q) * pointColor * falloff;
+		}
+	}
+
+	return lighting;
+}
+#endif
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 albedoLit = texelFetch(gAlbedo, pixel, 0);
+	vec3 albedo = albedoLit.rgb;
+	vec3 kd = texelFetch(gDiffuse, pixel, 0).rgb;
+	vec3 result;
+
+	if (albedoLit.a > 0.0)
+	{
+		float depth = texelFetch(gDepth, pixel, 0).r;
+		vec3 ndc = vec3((gl_FragCoord.xy - viewport.xy) / viewport.zw * 2.0 - 1.0, depth * depthToNdc.x + depthToNdc.y);
+		vec4 world = inverseViewProjection * vec4(ndc, 1.0);
+		vec3 fragmentPosition = world.xyz / world.w;
+
+		vec4 normalShininess = texelFetch(gNormal, pixel, 0);
+		vec3 N = normalize(normalShininess.xyz);
+		vec3 L = normalize(lightPosition - fragmentPosition);
+
+		// Ambiente + difusa
+		vec3 ka = texelFetch(gAmbient, pixel, 0).rgb;
+		vec3 ambient = ka * lightColor;
+		vec3 diffuse = kd * max(dot(N, L), 0.0) * lightColor;
+		result = (ambient + diffuse) * albedo;
+
+		// Especular (ks zerado nas variantes sem SPECULAR)
+		vec3 ks = texelFetch(gSpecular, pixel, 0).rgb;
+		if (any(greaterThan(ks, vec3(0.0))))
+		{
+			vec3 V = normalize(cameraPos.xyz - fragmentPosition);
+			vec3 R = normalize(reflect(-L, N));
+			result += ks * pow(max(dot(R, V), 0.0), normalShininess.w) * lightColor;
+		}
+#ifdef CLUSTERED
+		result += clusteredLighting(fragmentPosition, N, albedo, ks, normalShininess.w);
+#endif
+	}
+	else
+	{
+		// Sem iluminação: só a cor difusa do material
+		result = kd * albedo;
+	}
+
+	color = vec4(result, 1.0);
+}
\ No newline at end of file
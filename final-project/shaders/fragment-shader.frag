@@ -1,10 +1,18 @@
 #version 410
 
+// Variante escolhida com #define (ShaderPermutations), veja vertex-shader.vert
+
 // Declara as variáveis de entrada (inputs) do shader
+#ifdef VERTEX_COLOR
 in vec3 finalColor;
-in vec3 scaledNormal;
+#endif
+#ifdef TEXTURED
 in vec2 textureCoord;
+#endif
+#ifdef LIT
+in vec3 scaledNormal;
 in vec3 fragmentPosition;
+#endif
 
 // Declara as variáveis uniformes do shader. 
 uniform vec3 lightColor;
@@ -18,13 +26,110 @@ uniform vec3 ks;
 // Expoente de reflexão especular
 uniform float q;
 
-uniform vec3 cameraPos;
+// Matrizes da view ativa, compartilhadas por todos os programas (ViewUniforms)
+layout (std140) uniform View
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+};
+
 uniform sampler2D tex_buffer;
 
+#ifdef DEFERRED
+// Só as entradas da iluminação, que é calculada depois sobre o G-buffer (DeferredRenderer)
+layout (location = 0) out vec4 gAlbedo;   // Cor base, 1 se tem iluminação
+layout (location = 1) out vec4 gNormal;   // Normal, expoente especular
+layout (location = 2) out vec4 gAmbient;  // ka
+layout (location = 3) out vec4 gDiffuse;  // kd
+layout (location = 4) out vec4 gSpecular; // ks
+#else
 out vec4 color;
+#endif
+
+#ifdef CLUSTERED
+// Luzes pontuais, agrupadas por froxel na CPU (LightClusters)
+uniform samplerBuffer clusterLights;   // 2 texels por luz: posição + raio, cor
+uniform usamplerBuffer clusterRanges;  // Início e quantidade de luzes de cada froxel
+uniform usamplerBuffer clusterIndices; // Índices das luzes, agrupados por froxel
+
+layout (std140) uniform Clusters
+{
+    vec4 clusterGrid;     // Tiles em x e y, fatias em z, número de luzes
+    vec4 clusterDepth;    // Escala e bias da fatia, near e far
+    vec4 clusterViewport; // Origem da view e tamanho de um tile, em pixels
+};
+
+// Soma das luzes pontuais que alcançam o froxel deste fragmento. As luzes
+// pontuais usam a própria cor como intensidade sobre a cor base
+vec3 clusteredLighting(vec3 N, vec3 albedo)
+{
+	// O froxel vem da posição na tela e da profundidade (fatias exponenciais)
+	float depth = -(view * vec4(fragmentPosition, 1.0)).z;
+	float slice = floor(log(max(depth, clusterDepth.z)) * clusterDepth.x + clusterDepth.y);
+	ivec3 cell = ivec3(ivec2((gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw), int(slice));
+	cell = clamp(cell, ivec3(0), ivec3(clusterGrid.xyz) - 1);
+	int cluster = (cell.z * int(clusterGrid.y) + cell.y) * int(clusterGrid.x) + cell.x;
+
+	uvec2 range = texelFetch(clusterRanges, cluster).xy;
+	vec3 V = normalize(cameraPos.xyz - fragmentPosition);
+	vec3 lighting = vec3(0.0);
+
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+		vec3 pointColor = texelFetch(clusterLights, 2 * light + 1).rgb;
+
+		// Atenuação suave que chega a zero no raio da luz
+		vec3 toLight = positionRadius.xyz - fragmentPosition;
+		float distance2 = dot(toLight, toLight);
+		float falloff = clamp(1.0 - distance2 / (positionRadius.w * positionRadius.w), 0.0, 1.0);
+		falloff *= falloff;
+
+		vec3 L = toLight * inversesqrt(max(distance2, 1e-8));
+		lighting += albedo * max(dot(N, L), 0.0) * pointColor * falloff;
+#ifdef SPECULAR
+		vec3 R = reflect(-L, N);
+		lighting += ks * pow(max(dot(R, V), 0.0), q) * pointColor * falloff;
+#endif
+	}
+
+	return lighting;
+}
+#endif
 
 void main()
 {
+	// Cor base: textura e/ou cor do vértice
+	vec3 albedo = vec3(1.0);
+#ifdef TEXTURED
+	albedo = texture(tex_buffer, textureCoord).xyz;
+#endif
+#ifdef VERTEX_COLOR
+	albedo *= finalColor;
+#endif
+
+#ifdef DEFERRED
+	gDiffuse = vec4(kd, 0.0);
+#ifdef LIT
+	gAlbedo = vec4(albedo, 1.0);
+	gNormal = vec4(normalize(scaledNormal), q);
+	gAmbient = vec4(ka, 0.0);
+#ifdef SPECULAR
+	gSpecular = vec4(ks, 0.0);
+#else
+	gSpecular = vec4(0.0);
+#endif
+#else
+	gAlbedo = vec4(albedo, 0.0);
+	gNormal = vec4(0.0, 0.0, 1.0, 0.0);
+	gAmbient = vec4(0.0);
+	gSpecular = vec4(0.0);
+#endif
+#else
+#ifdef LIT
 	// Cálculo da parcela de iluminação ambiente
 	vec3 ambient = ka * lightColor;
 	
@@ -34,14 +139,24 @@ void main()
 	float diff = max(dot(N,L),0.0);
 	vec3 diffuse = kd * diff * lightColor;
 
-	vec3 V = normalize(cameraPos - fragmentPosition);
+	vec3 result = (ambient + diffuse) * albedo;
+
+#ifdef SPECULAR
+	vec3 V = normalize(cameraPos.xyz - fragmentPosition);
 	vec3 R = normalize(reflect(-L,N));
 	float spec = max(dot(R,V),0.0);
 	spec = pow(spec, q);
 	vec3 specular = ks * spec * lightColor;
-
-	vec3 texColor = texture(tex_buffer, textureCoord).xyz;
-	vec3 result = (ambient + diffuse) * texColor + specular;
+	result += specular;
+#endif
+#ifdef CLUSTERED
+	result += clusteredLighting(N, albedo);
+#endif
+#else
+	// Sem iluminação: só a cor difusa do material
+	vec3 result = kd * albedo;
+#endif
 
 	color = vec4(result, 1.0f);
+#endif
 }
\ No newline at end of file
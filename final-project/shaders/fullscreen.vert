@@ -0,0 +1,12 @@
+#version 410
+
+// Triângulo que cobre a viewport inteira, sem atributos: os cantos vêm de gl_VertexID
+
+// z em NDC de todo o triângulo, para que o teste de profundidade escolha os pixels
+uniform float fullscreenDepth;
+
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, fullscreenDepth, 1.0);
+}
\ No newline at end of file
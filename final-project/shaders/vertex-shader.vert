@@ -1,27 +1,59 @@
 #version 410
 
+// Variante escolhida com #define (ShaderPermutations): TEXTURED, LIT, SPECULAR,
+// VERTEX_COLOR e INSTANCED. Só as saídas usadas pela variante são calculadas
+
 // Declara as variáveis de entrada (inputs) do shader
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 tex_coord;
 layout (location = 3) in vec3 normal;
 
+#ifdef INSTANCED
+// Matriz model por instância (InstanceBuffer), ocupa as locations 4 a 7
+layout (location = 4) in mat4 model;
+#else
 // Declara as variáveis uniformes do shader
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+
+// Matrizes da view ativa, compartilhadas por todos os programas (ViewUniforms)
+layout (std140) uniform View
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+};
+
+// Mesma conta em todas as variantes: o pré-passo de profundidade e o passo com
+// cor precisam gerar exatamente as mesmas profundidades
+invariant gl_Position;
 
 // Declara as variáveis de saída (outputs) do shader
+#ifdef VERTEX_COLOR
 out vec3 finalColor;
-out vec3 scaledNormal;
+#endif
+#ifdef TEXTURED
 out vec2 textureCoord;
+#endif
+#ifdef LIT
+out vec3 scaledNormal;
 out vec3 fragmentPosition;
+#endif
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0);
-    scaledNormal = normal;
+    vec4 worldPosition = model * vec4(position, 1.0);
+    gl_Position = viewProjection * worldPosition;
+#ifdef VERTEX_COLOR
     finalColor = color;
+#endif
+#ifdef TEXTURED
     textureCoord = vec2(tex_coord.x, 1 - tex_coord.y);
-    fragmentPosition = vec3(model * vec4(position, 1.0));
+#endif
+#ifdef LIT
+    scaledNormal = normal;
+    fragmentPosition = vec3(worldPosition);
+#endif
 }
\ No newline at end of file
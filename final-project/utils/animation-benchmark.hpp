@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "animation.h"
+#include "benchmark-utils.hpp"
+
+using namespace std;
+
+// Key of a track at `time`, looking at every key: the last key at or before
+// the time, interpolated with the next one (the first key before the track starts)
+AnimationKeyframe sampleKeyframes(const vector<AnimationKeyframe> &keys, float time)
+{
+  size_t a = 0;
+  while (a + 1 < keys.size() && keys[a + 1].time <= time)
+    a++;
+  if (a + 1 >= keys.size() || time <= keys[a].time)
+    return keys[a];
+
+  const AnimationKeyframe &b = keys[a + 1];
+  float alpha = (time - keys[a].time) / (b.time - keys[a].time);
+  AnimationKeyframe key;
+  key.time = time;
+  key.position = glm::mix(keys[a].position, b.position, alpha);
+  key.rotation = glm::slerp(keys[a].rotation, b.rotation, alpha);
+  key.scale = glm::mix(keys[a].scale, b.scale, alpha);
+  return key;
+}
+
+// Largest difference between the sampler output and the keyframes, over all tracks
+float keyframeError(const vector<vector<AnimationKeyframe>> &tracks, float time, const vector<glm::vec3> &positions,
+                    const vector<glm::quat> &rotations, const vector<glm::vec3> &scales)
+{
+  float error = 0.0f;
+  for (size_t t = 0; t < tracks.size(); t++)
+  {
+    AnimationKeyframe key = sampleKeyframes(tracks[t], time);
+    glm::quat rotation = rotations[t];
+    error = max(error, glm::length(key.position - positions[t]));
+    error = max(error, glm::length(glm::vec4(key.rotation.x - rotation.x, key.rotation.y - rotation.y, key.rotation.z - rotation.z,
+                                             key.rotation.w - rotation.w)));
+    error = max(error, glm::length(key.scale - scales[t]));
+  }
+  return error;
+}
+
+// Builds a clip of `count` tracks of 32 keys at random times with build(),
+// saves it to the temporary directory and maps it back with
+// AnimationClip::load (a truncated copy, a track past the last key, unsorted
+// key times and a wrong magic must be rejected). The mapped clip must hold
+// the same bytes, and both clips are sampled by the AnimationSampler playing
+// forward (the per-track cursor) and seeking to random times (the binary
+// search), compared at each time with the keyframes looked up one by one.
+// Times are per sample() of all tracks.
+// Usage: ./main --animation-benchmark 1000
+void runAnimationBenchmark(int count)
+{
+  const int RUNS = 5;
+  const int KEYS = 32;
+  const int FRAMES = 600;
+  const float FRAME_STEP = 1.0f / 60.0f;
+  const string PATH = temporaryPath("animation-benchmark.anim");
+  char line[160];
+
+  srand(count);
+  vector<vector<AnimationKeyframe>> tracks(count, vector<AnimationKeyframe>(KEYS));
+  for (int t = 0; t < count; t++)
+  {
+    float time = 0.3f * randomUnit();
+    for (int k = 0; k < KEYS; k++)
+    {
+      AnimationKeyframe &key = tracks[t][k];
+      key.time = time;
+      key.position = glm::vec3(randomUnit(), randomUnit(), randomUnit()) * 10.0f;
+      key.rotation = glm::normalize(glm::quat(randomUnit() + 0.5f, randomUnit() - 0.5f, randomUnit() - 0.5f, randomUnit() - 0.5f));
+      key.scale = glm::vec3(0.5f + randomUnit());
+      time += 0.05f + 0.3f * randomUnit();
+    }
+  }
+
+  // addTrack copies the whole clip on each call, so it is timed on at most 1000 tracks
+  int addedTracks = min(count, 1000);
+  double addTime = timeBest(1, [&]()
+  {
+    AnimationClip added;
+    for (int t = 0; t < addedTracks; t++)
+      added.addTrack(tracks[t]);
+  });
+
+  AnimationClip clip;
+  double buildTime = timeBest(RUNS, [&]() { clip.build(tracks); });
+  double saveTime = timeBest(1, [&]() { clip.save(PATH); });
+
+  AnimationClip mapped;
+  bool loaded = false;
+  double loadTime = timeBest(1, [&]() { loaded = mapped.load(PATH); });
+  size_t size = sizeof(AnimationFileHeader) + count * sizeof(AnimationTrackInfo) + (size_t)count * KEYS * 11 * sizeof(float);
+  bool sameData = loaded && mapped.getNbTracks() == count && mapped.getDuration() == clip.getDuration() &&
+                  memcmp(mapped.getTracks(), clip.getTracks(), size - sizeof(AnimationFileHeader)) == 0;
+
+  // Invalid files: cut in the middle of the keys, a track past the last key,
+  // a track with its first two keys swapped and with another magic
+  vector<char> bytes(size);
+  ifstream(PATH.c_str(), ios::binary).read(bytes.data(), size);
+  AnimationClip invalid;
+  ofstream(PATH.c_str(), ios::binary).write(bytes.data(), size / 2);
+  bool rejectsTruncated = !invalid.load(PATH);
+
+  AnimationTrackInfo *lastTrack = (AnimationTrackInfo *)(bytes.data() + sizeof(AnimationFileHeader)) + count - 1;
+  lastTrack->firstKey++;
+  ofstream(PATH.c_str(), ios::binary).write(bytes.data(), size);
+  bool rejectsRange = !invalid.load(PATH);
+  lastTrack->firstKey--;
+
+  float *firstTimes = (float *)(lastTrack + 1);
+  swap(firstTimes[0], firstTimes[1]);
+  ofstream(PATH.c_str(), ios::binary).write(bytes.data(), size);
+  bool rejectsOrder = !invalid.load(PATH);
+  swap(firstTimes[0], firstTimes[1]);
+
+  bytes[0] = 'X';
+  ofstream(PATH.c_str(), ios::binary).write(bytes.data(), size);
+  bool rejectsMagic = !invalid.load(PATH);
+  remove(PATH.c_str());
+
+  cout << count << " tracks, " << KEYS << " keys each, " << clip.getDuration() << " s, " << size / 1024 << " KB" << endl;
+  snprintf(line, sizeof(line), "build %.1f ms (addTrack of %d tracks %.1f ms), save %.2f ms, load (mmap) %.3f ms", buildTime, addedTracks, addTime,
+           saveTime, loadTime);
+  cout << line << endl;
+  cout << "loaded: " << (sameData ? "same data" : "DIFFERENT DATA") << ", truncated file " << (rejectsTruncated ? "rejected" : "ACCEPTED")
+       << ", track out of range " << (rejectsRange ? "rejected" : "ACCEPTED") << ", unsorted keys " << (rejectsOrder ? "rejected" : "ACCEPTED")
+       << ", wrong magic " << (rejectsMagic ? "rejected" : "ACCEPTED") << endl;
+  if (!sameData)
+    return;
+
+  // Forward playback over two loops of the clip, and random seeks
+  vector<float> playTimes(FRAMES), seekTimes(FRAMES);
+  float frameStep = max(FRAME_STEP, 2.0f * clip.getDuration() / FRAMES);
+  for (int f = 0; f < FRAMES; f++)
+  {
+    playTimes[f] = f * frameStep;
+    seekTimes[f] = randomUnit() * clip.getDuration();
+  }
+
+  vector<glm::vec3> positions(count), scales(count);
+  vector<glm::quat> rotations(count);
+  cout << "clip     sampling  us / sample  ns / track  max error" << endl;
+
+  const AnimationClip *clips[2] = {&clip, &mapped};
+  const char *clipNames[2] = {"memory", "mapped"};
+  const vector<float> *times[2] = {&playTimes, &seekTimes};
+  const char *timeNames[2] = {"forward", "seek"};
+  for (int c = 0; c < 2; c++)
+  {
+    for (int s = 0; s < 2; s++)
+    {
+      const vector<float> &sampleTimes = *times[s];
+      AnimationSampler sampler;
+      sampler.initialize(clips[c]);
+
+      float maxError = 0.0f;
+      for (int f = 0; f < FRAMES; f++)
+      {
+        sampler.sample(sampleTimes[f], positions.data(), rotations.data(), scales.data());
+        float time = fmod(sampleTimes[f], clip.getDuration());
+        maxError = max(maxError, keyframeError(tracks, time, positions, rotations, scales));
+      }
+
+      double sampleTime = timeBest(RUNS, [&]()
+      {
+        for (int f = 0; f < FRAMES; f++)
+          sampler.sample(sampleTimes[f], positions.data(), rotations.data(), scales.data());
+      });
+      double microseconds = sampleTime * 1000.0 / FRAMES;
+      snprintf(line, sizeof(line), "%-8s %-9s %-12.2f %-11.1f %g", clipNames[c], timeNames[s], microseconds, microseconds * 1000.0 / count, maxError);
+      cout << line << endl;
+    }
+  }
+}
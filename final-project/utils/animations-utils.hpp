@@ -1,3 +1,5 @@
+#pragma once
+
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -6,6 +8,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "animation.h"
+
 using namespace std;
 
 vector<glm::vec3> generateControlPointsSet(string fileName)
@@ -26,4 +30,12 @@ vector<glm::vec3> generateControlPointsSet(string fileName)
 	configFile.close();
 
 	return controlPoints;
-}
\ No newline at end of file
+}
+
+// Loads a binary track file (animations/<fileName>.anim). Unlike the text
+// control point files it holds any number of tracks with time-stamped
+// position, rotation and scale keyframes and is memory-mapped, not parsed.
+bool loadAnimationClip(string fileName, AnimationClip &clip)
+{
+	return clip.load("./animations/" + fileName + ".anim");
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+using namespace std;
+
+// Helpers shared by the --*-benchmark modes, so they don't include each other
+
+// Best time, in ms, of `runs` calls of `work`
+double timeBest(int runs, const function<void()> &work)
+{
+  double best = 1e30;
+  for (int run = 0; run < runs; run++)
+  {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    work();
+    best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+// Uniform in [0, 1], from rand() (seeded by each benchmark for repeatable runs)
+float randomUnit()
+{
+  return (float)rand() / (float)RAND_MAX;
+}
+
+// Path for a scratch file in the system temporary directory, outside the source tree
+string temporaryPath(const string &fileName)
+{
+#ifdef _WIN32
+  const char *directory = getenv("TEMP");
+  return string(directory ? directory : ".") + "\\" + fileName;
+#else
+  const char *directory = getenv("TMPDIR");
+  return string(directory ? directory : "/tmp") + "/" + fileName;
+#endif
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchmark-utils.hpp"
+#include "bvh.h"
+#include "camera.h"
+
+using namespace std;
+
+// Box of each sphere, the bounds the BVH is built over
+void sphereBounds(const vector<glm::vec3> &centers, const vector<float> &radii, vector<glm::vec3> &mins, vector<glm::vec3> &maxs)
+{
+  for (size_t i = 0; i < centers.size(); i++)
+  {
+    mins[i] = centers[i] - glm::vec3(radii[i]);
+    maxs[i] = centers[i] + glm::vec3(radii[i]);
+  }
+}
+
+bool isBoxInFrustum(const glm::vec4 *planes, const glm::vec3 &min, const glm::vec3 &max)
+{
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+  {
+    glm::vec3 normal = glm::vec3(planes[i]);
+    glm::vec3 positive(normal.x >= 0.0f ? max.x : min.x, normal.y >= 0.0f ? max.y : min.y, normal.z >= 0.0f ? max.z : min.z);
+    if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+// Spheres (radius 0.1 to 0.5) scattered in a cube with one sphere per 8 cubic
+// units, so every count has the same density. For each count, times the SAH
+// build, a refit after every sphere moved, and frustum, ray (closest sphere)
+// and range (spheres within 5 units) queries against testing every sphere,
+// and checks that both find the same spheres.
+// Usage: ./main --bvh-benchmark 1000000    (10 000 objects up to this count, x10 each step)
+void runBvhBenchmark(int maxCount)
+{
+  const int RUNS = 5;
+  const int RAYS = 1000;
+  const int RANGES = 1000;
+  const float RANGE_RADIUS = 5.0f;
+  char line[160];
+
+  cout << "count     build ms  nodes    depth  sah    refit ms  | query: bvh ms / brute ms (speedup)" << endl;
+
+  for (int count = 10000; count <= maxCount; count *= 10)
+  {
+    srand(count);
+    float side = 2.0f * cbrt((float)count);
+
+    vector<glm::vec3> centers(count), mins(count), maxs(count);
+    vector<float> radii(count);
+    for (int i = 0; i < count; i++)
+    {
+      centers[i] = glm::vec3(randomUnit(), randomUnit(), randomUnit()) * side;
+      radii[i] = 0.1f + 0.4f * randomUnit();
+    }
+    sphereBounds(centers, radii, mins, maxs);
+
+    Bvh bvh;
+    double buildTime = timeBest(RUNS, [&]() { bvh.build(mins.data(), maxs.data(), count); });
+
+    // Every sphere moves a little, like the objects of a frame, and the tree is refitted
+    for (int i = 0; i < count; i++)
+      centers[i] += (glm::vec3(randomUnit(), randomUnit(), randomUnit()) - 0.5f) * 0.2f;
+    sphereBounds(centers, radii, mins, maxs);
+    double refitTime = timeBest(RUNS, [&]() { bvh.refit(mins.data(), maxs.data()); });
+
+    snprintf(line, sizeof(line), "%-9d %-9.3f %-8d %-6d %-6.1f %-9.3f", count, buildTime, bvh.getNodeCount(), bvh.getDepth(), bvh.getSahCost(), refitTime);
+    cout << line << endl;
+
+    // Frustum: a camera in a corner of the cube looking at its center
+    Camera camera;
+    camera.initialize(nullptr, 1000, 1000, 0.05f, 0.0f, -90.0f, glm::normalize(glm::vec3(1.0f)), glm::vec3(0.0f));
+    camera.setPerspective(45.0f, 0.1f, side);
+    camera.update(0.0f);
+    const glm::vec4 *planes = camera.getFrustumPlanes();
+
+    vector<int> found, expected;
+    double bvhFrustum = timeBest(RUNS, [&]() { found.clear(); bvh.queryFrustum(planes, found); });
+    double bruteFrustum = timeBest(RUNS, [&]()
+    {
+      expected.clear();
+      for (int i = 0; i < count; i++)
+        if (isBoxInFrustum(planes, mins[i], maxs[i]))
+          expected.push_back(i);
+    });
+    snprintf(line, sizeof(line), "  frustum  %8.3f / %9.3f ms (%6.1fx)  %d visible%s", bvhFrustum, bruteFrustum, bruteFrustum / bvhFrustum,
+             (int)found.size(), found.size() == expected.size() ? "" : "  MISMATCH");
+    cout << line << endl;
+
+    // Rays: closest sphere along random rays from inside the cube
+    vector<glm::vec3> origins(RAYS), directions(RAYS);
+    for (int r = 0; r < RAYS; r++)
+    {
+      origins[r] = glm::vec3(randomUnit(), randomUnit(), randomUnit()) * side;
+      directions[r] = glm::normalize(glm::vec3(randomUnit(), randomUnit(), randomUnit()) - 0.5f);
+    }
+
+    int bvhHits = 0, bruteHits = 0;
+    bool sameHits = true;
+    vector<int> hits(RAYS);
+    double bvhRays = timeBest(RUNS, [&]()
+    {
+      bvhHits = 0;
+      for (int r = 0; r < RAYS; r++)
+      {
+        float distance;
+        hits[r] = bvh.raycast(origins[r], directions[r], side * 2.0f, distance, [&](int item, float maxDistance)
+                              { return Bvh::intersectSphere(centers[item], radii[item], origins[r], directions[r], maxDistance); });
+        bvhHits += hits[r] >= 0;
+      }
+    });
+    double bruteRays = timeBest(1, [&]()
+    {
+      bruteHits = 0;
+      for (int r = 0; r < RAYS; r++)
+      {
+        int hit = -1;
+        float closest = side * 2.0f;
+        for (int i = 0; i < count; i++)
+        {
+          float distance = Bvh::intersectSphere(centers[i], radii[i], origins[r], directions[r], closest);
+          if (distance >= 0.0f && distance < closest)
+          {
+            closest = distance;
+            hit = i;
+          }
+        }
+        bruteHits += hit >= 0;
+        sameHits = sameHits && hit == hits[r];
+      }
+    });
+    snprintf(line, sizeof(line), "  rays     %8.3f / %9.3f ms (%6.1fx)  %d rays, %d hits%s", bvhRays, bruteRays, bruteRays / bvhRays, RAYS, bvhHits,
+             sameHits && bvhHits == bruteHits ? "" : "  MISMATCH");
+    cout << line << endl;
+
+    // Range: spheres whose box is within RANGE_RADIUS of random points
+    int bvhFound = 0, bruteFound = 0;
+    double bvhRange = timeBest(RUNS, [&]()
+    {
+      bvhFound = 0;
+      for (int q = 0; q < RANGES; q++)
+      {
+        found.clear();
+        bvh.querySphere(origins[q % RAYS], RANGE_RADIUS, found);
+        bvhFound += (int)found.size();
+      }
+    });
+    double bruteRange = timeBest(1, [&]()
+    {
+      bruteFound = 0;
+      for (int q = 0; q < RANGES; q++)
+        for (int i = 0; i < count; i++)
+        {
+          glm::vec3 offset = glm::clamp(origins[q % RAYS], mins[i], maxs[i]) - origins[q % RAYS];
+          bruteFound += glm::dot(offset, offset) <= RANGE_RADIUS * RANGE_RADIUS;
+        }
+    });
+    snprintf(line, sizeof(line), "  range    %8.3f / %9.3f ms (%6.1fx)  %d queries, %d found%s", bvhRange, bruteRange, bruteRange / bvhRange, RANGES, bvhFound,
+             bvhFound == bruteFound ? "" : "  MISMATCH");
+    cout << line << endl;
+  }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "benchmark-utils.hpp"
+#include "bezier.h"
+
+using namespace std;
+
+// Bezier curves from 34 to 34000 control points (100 points per segment, like
+// the orbit): times moving one control point with setControlPoint (the
+// segments that use it re-evaluated and patched with glBufferSubData) against
+// rebuilding the whole curve with generateCurve. glFinish is inside the timed
+// work, so the uploads are counted. After the edits the curve is compared with
+// one generated from scratch with the same control points.
+// Usage: ./main --curve-benchmark    (needs an OpenGL context, also with --headless)
+void runCurveBenchmark()
+{
+  const int RUNS = 5;
+  const int EDITS = 1000;
+  const int POINTS_PER_SEGMENT = 100;
+  char line[160];
+
+  cout << "control points  segments  edit us  rebuild ms  (rebuild / edit)" << endl;
+
+  for (int count = 34; count <= 34000; count *= 10)
+  {
+    srand(count);
+    vector<glm::vec3> controlPoints(count);
+    for (int i = 0; i < count; i++)
+      controlPoints[i] = glm::vec3(i * 0.1f, rand() % 100 / 100.0f, rand() % 100 / 100.0f);
+
+    Bezier curve;
+    curve.setControlPoints(controlPoints);
+    curve.generateCurve(POINTS_PER_SEGMENT);
+
+    vector<int> edited(EDITS);
+    for (int e = 0; e < EDITS; e++)
+      edited[e] = rand() % count;
+
+    double editTime = timeBest(RUNS, [&]()
+    {
+      for (int e = 0; e < EDITS; e++)
+      {
+        controlPoints[edited[e]].y += 0.01f;
+        curve.setControlPoint(edited[e], controlPoints[edited[e]]);
+      }
+      glFinish();
+    });
+    double rebuildTime = timeBest(RUNS, [&]()
+    {
+      curve.generateCurve(POINTS_PER_SEGMENT);
+      glFinish();
+    });
+
+    // The rebuild above already replaced the edited curve: edit again before comparing
+    for (int e = 0; e < EDITS; e++)
+    {
+      controlPoints[edited[e]].z -= 0.01f;
+      curve.setControlPoint(edited[e], controlPoints[edited[e]]);
+    }
+    Bezier reference;
+    reference.setControlPoints(controlPoints);
+    reference.generateCurve(POINTS_PER_SEGMENT);
+    float maxError = 0.0f;
+    for (int p = 0; p < curve.getNbCurvePoints(); p++)
+      maxError = max(maxError, glm::length(curve.getPointOnCurve(p) - reference.getPointOnCurve(p)));
+
+    double editMicroseconds = editTime * 1000.0 / EDITS;
+    snprintf(line, sizeof(line), "%-15d %-9d %-8.2f %-11.3f (%.0fx)", count, (count - 1) / 3, editMicroseconds, rebuildTime,
+             rebuildTime * 1000.0 / editMicroseconds);
+    cout << line;
+    if (maxError > 0.0f)
+      cout << "  MISMATCH " << maxError;
+    cout << endl;
+
+    curve.release();
+    reference.release();
+  }
+}
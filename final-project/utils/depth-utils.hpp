@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "camera.h"
+
+using namespace std;
+
+// glClipControl is core only since OpenGL 4.5 (GL_ARB_clip_control), so it is
+// not part of our GLAD 4.1 loader and has to be looked up at runtime
+#ifndef GL_LOWER_LEFT
+#define GL_LOWER_LEFT 0x8CA1
+#endif
+#ifndef GL_ZERO_TO_ONE
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+
+typedef void (APIENTRYP PFNGLCLIPCONTROLPROC)(GLenum origin, GLenum depth);
+
+bool hasClipControl()
+{
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major > 4 || (major == 4 && minor >= 5))
+    return true;
+
+  GLint extensionCount = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (GLint i = 0; i < extensionCount; i++)
+  {
+    if (strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), "GL_ARB_clip_control") == 0)
+      return true;
+  }
+
+  return false;
+}
+
+// Sets the depth state used by Camera::setReverseZ: cleared to 0, nearer
+// fragments have greater depth. With glClipControl the NDC depth [0, 1] is
+// written as is; without it GL maps [-1, 1] to [0, 1], so reverse-Z still
+// renders correctly but only uses the [0.5, 1] range (less precision).
+// Returns whether glClipControl was available.
+bool enableReverseZ(GLADloadproc load)
+{
+  bool clipControl = false;
+
+  if (hasClipControl())
+  {
+    PFNGLCLIPCONTROLPROC clipControlProc = (PFNGLCLIPCONTROLPROC)load("glClipControl");
+    if (clipControlProc)
+    {
+      clipControlProc(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+      clipControl = true;
+    }
+  }
+
+  if (!clipControl)
+    cout << "glClipControl not available, reverse-Z will use half of the depth range" << endl;
+
+  glDepthFunc(GL_GREATER);
+  glClearDepth(0.0);
+  return clipControl;
+}
+
+// Depth value written to the depth buffer for a point at the given distance
+// in front of the camera, quantized like a GL_DEPTH_COMPONENT24 or 32F buffer
+double quantizedDepth(const glm::mat4 &projection, float distance, bool zeroToOne, bool floatDepth)
+{
+  glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+  float ndc = clip.z / clip.w;
+  float window = zeroToOne ? ndc : ndc * 0.5f + 0.5f;
+
+  if (floatDepth)
+    return window;
+
+  const double maxValue = 16777215.0; // 2^24 - 1
+  return floor(glm::clamp((double)window, 0.0, 1.0) * maxValue + 0.5);
+}
+
+// Smallest relative gap (dz / z) between two surfaces at this distance that
+// still ends up with different depth values, i.e. without z-fighting
+double depthResolution(const glm::mat4 &projection, float distance, bool zeroToOne, bool floatDepth)
+{
+  double depth = quantizedDepth(projection, distance, zeroToOne, floatDepth);
+  double low = 1e-9, high = 1.0;
+
+  if (quantizedDepth(projection, distance * (1.0 + high), zeroToOne, floatDepth) == depth)
+    return high;
+
+  for (int i = 0; i < 60; i++)
+  {
+    double middle = sqrt(low * high);
+    if (quantizedDepth(projection, distance * (1.0 + middle), zeroToOne, floatDepth) == depth)
+      low = middle;
+    else
+      high = middle;
+  }
+
+  return high;
+}
+
+// Compares a standard 24-bit projection with the reverse-Z infinite one from
+// 1 to 10^8 units and checks that reverse-Z (with clip control and a 32F
+// buffer) keeps every distance separable at 0.001% or better.
+// Usage: ./main --depth-report
+bool runDepthPrecisionReport()
+{
+  const float nearPlane = 0.1f;
+  const float farPlane = 1e6f;
+  const double requiredResolution = 1e-5;
+
+  Camera standard, reverse;
+  standard.initialize(nullptr, 1, 1);
+  standard.setPerspective(45.0f, nearPlane, farPlane);
+  standard.update(0.0f);
+  reverse.initialize(nullptr, 1, 1);
+  reverse.setPerspective(45.0f, nearPlane, farPlane);
+  reverse.setReverseZ(true);
+  reverse.update(0.0f);
+
+  bool passed = true;
+  char line[128];
+
+  cout << "Relative depth resolution (dz / z), near " << nearPlane << ", standard far " << farPlane << endl;
+  cout << "distance      standard D24    reverse 32F     reverse 32F no clip control" << endl;
+
+  for (float distance = 1.0f; distance <= 1e8f; distance *= 10.0f)
+  {
+    double standardResolution = distance < farPlane ? depthResolution(standard.getProjectionMatrix(), distance, false, false) : 1.0;
+    double reverseResolution = depthResolution(reverse.getProjectionMatrix(), distance, true, true);
+    double fallbackResolution = depthResolution(reverse.getProjectionMatrix(), distance, false, true);
+
+    snprintf(line, sizeof(line), "%-13g %-15.3g %-15.3g %-15.3g", distance, standardResolution, reverseResolution, fallbackResolution);
+    cout << line << (distance < farPlane ? "" : " (standard clipped)") << endl;
+
+    if (reverseResolution > requiredResolution)
+      passed = false;
+  }
+
+  // The projected point must also stay inside the depth range, even far away
+  glm::vec4 clip = reverse.getProjectionMatrix() * glm::vec4(0.0f, 0.0f, -1e20f, 1.0f);
+  if (clip.z < 0.0f || clip.z > clip.w)
+    passed = false;
+
+  cout << "Depth precision " << (passed ? "PASSED" : "FAILED") << endl;
+  return passed;
+}
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "image-utils.hpp"
+
+using namespace std;
+
+struct RunOptions
+{
+  bool headless = false;
+  int frames = 600;
+  float fixedStep = 1.0f / 60.0f;
+  string replayPath;
+  string recordPath;
+  string timingsPath = "timings.csv";
+  string capturePath;
+  string tracePath;
+  bool overlay = false;
+  bool reverseZ = false;
+  bool depthReport = false;
+  int jobBenchmark = 0;
+  int sceneBenchmark = 0;
+  string shaderCachePath = "shader-cache";
+  int lights = 0;
+  bool lightBenchmark = false;
+  bool deferred = false;
+  bool depthPrepass = false;
+  int sortBenchmark = 0;
+  int forcedLod = -1; // -1: level of detail chosen by screen size
+  int bvhBenchmark = 0;
+  bool rayBenchmark = false;
+  bool occlusionCulling = true;
+  int occlusionBenchmark = 0;
+  bool curveBenchmark = false;
+  int animationBenchmark = 0;
+};
+
+// Parses the command line, e.g.:
+//   ./main --headless --frames 600 --step 0.016666 --replay replays/orbit.txt --timings timings.csv --capture captures/
+//   ./main --record replays/recorded.txt    (then --headless --replay replays/recorded.txt)
+//   ./main --trace trace.json --overlay
+//   ./main --reverse-z
+//   ./main --depth-report
+//   ./main --job-benchmark 100000
+//   ./main --scene-benchmark 100000
+//   ./main --shader-cache /tmp/shader-cache    (or --no-shader-cache)
+//   ./main --lights 256
+//   ./main --light-benchmark
+//   ./main --lights 256 --deferred
+//   ./main --lights 256 --depth-prepass
+//   ./main --sort-benchmark 10000
+//   ./main --headless --lod 2    (every object drawn with level of detail 2)
+//   ./main --bvh-benchmark 1000000
+//   ./main --ray-benchmark
+//   ./main --headless --no-occlusion-culling
+//   ./main --occlusion-benchmark 10000
+//   ./main --headless --curve-benchmark
+//   ./main --animation-benchmark 1000
+RunOptions parseRunOptions(int argc, char **argv)
+{
+  RunOptions options;
+
+  for (int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--headless")
+      options.headless = true;
+    else if (arg == "--frames" && hasValue)
+      options.frames = atoi(argv[++i]);
+    else if (arg == "--step" && hasValue)
+      options.fixedStep = atof(argv[++i]);
+    else if (arg == "--replay" && hasValue)
+      options.replayPath = argv[++i];
+    else if (arg == "--record" && hasValue)
+      options.recordPath = argv[++i];
+    else if (arg == "--timings" && hasValue)
+      options.timingsPath = argv[++i];
+    else if (arg == "--capture" && hasValue)
+      options.capturePath = argv[++i];
+    else if (arg == "--trace" && hasValue)
+      options.tracePath = argv[++i];
+    else if (arg == "--overlay")
+      options.overlay = true;
+    else if (arg == "--reverse-z")
+      options.reverseZ = true;
+    else if (arg == "--depth-report")
+      options.depthReport = true;
+    else if (arg == "--job-benchmark" && hasValue)
+      options.jobBenchmark = atoi(argv[++i]);
+    else if (arg == "--scene-benchmark" && hasValue)
+      options.sceneBenchmark = atoi(argv[++i]);
+    else if (arg == "--shader-cache" && hasValue)
+      options.shaderCachePath = argv[++i];
+    else if (arg == "--no-shader-cache")
+      options.shaderCachePath = "";
+    else if (arg == "--lights" && hasValue)
+      options.lights = atoi(argv[++i]);
+    else if (arg == "--light-benchmark")
+      options.lightBenchmark = true;
+    else if (arg == "--deferred")
+      options.deferred = true;
+    else if (arg == "--depth-prepass")
+      options.depthPrepass = true;
+    else if (arg == "--sort-benchmark" && hasValue)
+      options.sortBenchmark = atoi(argv[++i]);
+    else if (arg == "--lod" && hasValue)
+      options.forcedLod = atoi(argv[++i]);
+    else if (arg == "--bvh-benchmark" && hasValue)
+      options.bvhBenchmark = atoi(argv[++i]);
+    else if (arg == "--ray-benchmark")
+      options.rayBenchmark = true;
+    else if (arg == "--no-occlusion-culling")
+      options.occlusionCulling = false;
+    else if (arg == "--occlusion-benchmark" && hasValue)
+      options.occlusionBenchmark = atoi(argv[++i]);
+    else if (arg == "--curve-benchmark")
+      options.curveBenchmark = true;
+    else if (arg == "--animation-benchmark" && hasValue)
+      options.animationBenchmark = atoi(argv[++i]);
+    else
+      cout << "Unknown option: " << arg << endl;
+  }
+
+  return options;
+}
+
+#ifdef USE_EGL
+// Creates an OpenGL 4.1 core context without any window or display server.
+// With Mesa this runs on llvmpipe, so it works on GPU-less Linux machines.
+bool createHeadlessContext()
+{
+  EGLDisplay display = EGL_NO_DISPLAY;
+
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (getPlatformDisplay)
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+  if (display == EGL_NO_DISPLAY)
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint major, minor;
+  if (!eglInitialize(display, &major, &minor))
+  {
+    cout << "Failed to initialize EGL" << endl;
+    return false;
+  }
+
+  const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config;
+  EGLint configCount = 0;
+  eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+  eglBindAPI(EGL_OPENGL_API);
+
+  const EGLint contextAttributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, 1,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE};
+  EGLContext context = eglCreateContext(display, configCount ? config : (EGLConfig)0, EGL_NO_CONTEXT, contextAttributes);
+
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+  {
+    cout << "Failed to create EGL context" << endl;
+    return false;
+  }
+
+  return gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+}
+
+// Loader for functions outside of GLAD (e.g. glClipControl)
+GLADloadproc getHeadlessProcLoader()
+{
+  return (GLADloadproc)eglGetProcAddress;
+}
+#else
+// Without EGL the headless mode falls back to an invisible GLFW window
+bool createHeadlessContext()
+{
+  glfwInit();
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow *window = glfwCreateWindow(1, 1, "Headless", nullptr, nullptr);
+  if (!window)
+  {
+    cout << "Failed to create hidden window" << endl;
+    return false;
+  }
+
+  glfwMakeContextCurrent(window);
+  return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+}
+
+GLADloadproc getHeadlessProcLoader()
+{
+  return (GLADloadproc)glfwGetProcAddress;
+}
+#endif
+
+struct OffscreenTarget
+{
+  GLuint FBO;
+  GLuint colorBuffer;
+  GLuint depthBuffer;
+  int width;
+  int height;
+};
+
+// Framebuffer the headless mode renders into instead of the window
+// (reverse-Z uses it with GL_DEPTH_COMPONENT32F in windowed mode too)
+OffscreenTarget createOffscreenTarget(int width, int height, GLenum depthFormat = GL_DEPTH_COMPONENT24)
+{
+  OffscreenTarget target;
+  target.width = width;
+  target.height = height;
+
+  glGenRenderbuffers(1, &target.colorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, target.colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &target.depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, target.depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &target.FBO);
+  glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.colorBuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depthBuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    cout << "Offscreen framebuffer is incomplete" << endl;
+
+  return target;
+}
+
+void deleteOffscreenTarget(OffscreenTarget &target)
+{
+  glDeleteFramebuffers(1, &target.FBO);
+  glDeleteRenderbuffers(1, &target.colorBuffer);
+  glDeleteRenderbuffers(1, &target.depthBuffer);
+}
+
+bool captureFrame(const OffscreenTarget &target, const string &folder, int frame)
+{
+  vector<unsigned char> pixels(target.width * target.height * 4);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.FBO);
+  glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "frame-%05d.png", frame);
+
+  return writePNG(folder + "/" + fileName, target.width, target.height, pixels);
+}
+
+// Records per-frame CPU time and GPU time (GL_TIMESTAMP pairs, so the
+// profiler's GL_TIME_ELAPSED scopes can still run inside the frame). GPU
+// results are read a few frames later so the query never stalls the pipeline.
+class FrameTimings
+{
+public:
+  static const int QUERY_LATENCY = 4;
+
+  void initialize(int frames)
+  {
+    cpuMilliseconds.assign(frames, 0.0);
+    gpuMilliseconds.assign(frames, 0.0);
+    glGenQueries(QUERY_LATENCY * 2, queries);
+  }
+
+  void beginFrame(int frame)
+  {
+    if (frame >= QUERY_LATENCY)
+      readGPUTime(frame - QUERY_LATENCY);
+
+    cpuStart = chrono::steady_clock::now();
+    glQueryCounter(queries[(frame % QUERY_LATENCY) * 2], GL_TIMESTAMP);
+  }
+
+  void endFrame(int frame)
+  {
+    glQueryCounter(queries[(frame % QUERY_LATENCY) * 2 + 1], GL_TIMESTAMP);
+    cpuMilliseconds[frame] = chrono::duration<double, milli>(chrono::steady_clock::now() - cpuStart).count();
+  }
+
+  // Reads the queries still in flight and writes "frame,cpu_ms,gpu_ms" rows
+  bool save(const string &path, int frames)
+  {
+    for (int frame = max(0, frames - QUERY_LATENCY); frame < frames; frame++)
+      readGPUTime(frame);
+
+    glDeleteQueries(QUERY_LATENCY * 2, queries);
+
+    ofstream file(path.c_str());
+    if (!file.is_open())
+    {
+      cout << "Failed to open file: " << path << endl;
+      return false;
+    }
+
+    double cpuTotal = 0.0, gpuTotal = 0.0;
+    file << "frame,cpu_ms,gpu_ms" << endl;
+    for (int frame = 0; frame < frames; frame++)
+    {
+      file << frame << "," << cpuMilliseconds[frame] << "," << gpuMilliseconds[frame] << endl;
+      cpuTotal += cpuMilliseconds[frame];
+      gpuTotal += gpuMilliseconds[frame];
+    }
+
+    cout << "Frames: " << frames << " | avg CPU " << cpuTotal / max(frames, 1) << " ms | avg GPU " << gpuTotal / max(frames, 1) << " ms" << endl;
+    return true;
+  }
+
+protected:
+  void readGPUTime(int frame)
+  {
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(queries[(frame % QUERY_LATENCY) * 2], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(queries[(frame % QUERY_LATENCY) * 2 + 1], GL_QUERY_RESULT, &end);
+    gpuMilliseconds[frame] = (end - start) / 1000000.0;
+  }
+
+  GLuint queries[QUERY_LATENCY * 2];
+  chrono::steady_clock::time_point cpuStart;
+  vector<double> cpuMilliseconds;
+  vector<double> gpuMilliseconds;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+// Minimal PNG writer used by the headless frame capture. The image data is
+// stored with uncompressed deflate blocks, so no zlib dependency is needed.
+
+uint32_t pngCrc32(const unsigned char *data, size_t length, uint32_t crc = 0)
+{
+  static uint32_t table[256];
+  static bool tableReady = false;
+
+  if (!tableReady)
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++)
+      {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+    tableReady = true;
+  }
+
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+void appendBigEndian(vector<unsigned char> &out, uint32_t value)
+{
+  out.push_back((value >> 24) & 0xFF);
+  out.push_back((value >> 16) & 0xFF);
+  out.push_back((value >> 8) & 0xFF);
+  out.push_back(value & 0xFF);
+}
+
+void appendPNGChunk(vector<unsigned char> &out, const char *type, const vector<unsigned char> &data)
+{
+  appendBigEndian(out, data.size());
+
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+
+  appendBigEndian(out, pngCrc32(&out[start], out.size() - start));
+}
+
+// Writes RGBA pixels read with glReadPixels (bottom row first) as a PNG file
+bool writePNG(const string &path, int width, int height, const vector<unsigned char> &pixels)
+{
+  vector<unsigned char> png;
+  const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  png.insert(png.end(), signature, signature + 8);
+
+  vector<unsigned char> header;
+  appendBigEndian(header, width);
+  appendBigEndian(header, height);
+  header.push_back(8); // bit depth
+  header.push_back(6); // RGBA
+  header.push_back(0); // compression
+  header.push_back(0); // filter
+  header.push_back(0); // interlace
+  appendPNGChunk(png, "IHDR", header);
+
+  // Raw scanlines, each one prefixed by the "None" filter type, flipped to top row first
+  size_t rowSize = width * 4;
+  vector<unsigned char> raw;
+  raw.reserve((rowSize + 1) * height);
+  for (int y = height - 1; y >= 0; y--)
+  {
+    raw.push_back(0);
+    raw.insert(raw.end(), pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize);
+  }
+
+  // zlib stream made of stored deflate blocks (at most 65535 bytes each)
+  vector<unsigned char> zlib;
+  zlib.push_back(0x78);
+  zlib.push_back(0x01);
+
+  uint32_t a = 1, b = 0;
+  for (size_t offset = 0; offset < raw.size(); offset += 65535)
+  {
+    size_t length = min((size_t)65535, raw.size() - offset);
+    bool last = offset + length >= raw.size();
+
+    zlib.push_back(last ? 1 : 0);
+    zlib.push_back(length & 0xFF);
+    zlib.push_back((length >> 8) & 0xFF);
+    zlib.push_back(~length & 0xFF);
+    zlib.push_back((~length >> 8) & 0xFF);
+    zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+
+    for (size_t i = offset; i < offset + length; i++)
+    {
+      a = (a + raw[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+  }
+  appendBigEndian(zlib, (b << 16) | a);
+  appendPNGChunk(png, "IDAT", zlib);
+
+  appendPNGChunk(png, "IEND", vector<unsigned char>());
+
+  ofstream file(path.c_str(), ios::binary);
+  if (!file.is_open())
+  {
+    cout << "Failed to open file: " << path << endl;
+    return false;
+  }
+
+  file.write((const char *)png.data(), png.size());
+  return file.good();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera.h"
+#include "job-system.h"
+#include "transform-system.h"
+
+using namespace std;
+
+// Per-object work of a frame: model matrices from the transform arrays plus a
+// bounding sphere test against the camera frustum
+void updateObjects(int begin, int end, const TransformSystem &transforms, const glm::vec4 *frustumPlanes, vector<glm::mat4> &models,
+                   vector<char> &visible)
+{
+  transforms.computeModels(begin, end, models.data());
+
+  for (int i = begin; i < end; i++)
+    visible[i] = Camera::isSphereInFrustum(frustumPlanes, transforms.getPosition(i), transforms.getScale(i).x);
+}
+
+// Times the per-object update of `objects` objects with 1..N threads through
+// the job system and prints the speedup over a single thread.
+// Usage: ./main --job-benchmark 100000
+void runJobBenchmark(int objects)
+{
+  const int RUNS = 20;
+  const int GRAIN_SIZE = 1024;
+
+  TransformSystem transforms;
+  vector<glm::mat4> models(objects);
+  vector<char> visible(objects);
+
+  srand(1);
+  for (int i = 0; i < objects; i++)
+  {
+    glm::vec3 position = glm::vec3(rand() % 200 - 100, rand() % 200 - 100, rand() % 200 - 100);
+    float angle = (rand() % 628) / 100.0f;
+    int object = transforms.create(position, glm::vec3(0.1f + (rand() % 100) / 100.0f));
+    transforms.setRotation(object, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+  }
+
+  Camera camera;
+  camera.initialize(nullptr, 1, 1);
+  camera.update(0.0f);
+
+  int maxThreads = max(1, (int)std::thread::hardware_concurrency());
+  double singleThread = 0.0;
+  char line[128];
+
+  cout << objects << " objects, grain " << GRAIN_SIZE << ", " << RUNS << " runs" << endl;
+  cout << "threads  ms/frame  speedup" << endl;
+
+  for (int threads = 1; threads <= maxThreads; threads++)
+  {
+    JobSystem jobs;
+    jobs.initialize(threads - 1);
+
+    double best = 1e30;
+    for (int run = 0; run < RUNS; run++)
+    {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+      jobs.parallelFor(objects, GRAIN_SIZE, [&](int begin, int end)
+      {
+        updateObjects(begin, end, transforms, camera.getFrustumPlanes(), models, visible);
+      });
+
+      best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+
+    if (threads == 1)
+      singleThread = best;
+
+    snprintf(line, sizeof(line), "%-8d %-9.3f %.2fx", threads, best, singleThread / best);
+    cout << line << endl;
+
+    jobs.shutdown();
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "light-clusters.h"
+
+using namespace std;
+
+// Point lights orbiting the Earth-Moon system: `count` lights spread over
+// rings between 0.25 and 1.5 units from the center, each with its own color
+vector<PointLight> createOrbitLights(int count)
+{
+  vector<PointLight> lights(count);
+
+  srand(7);
+  for (int i = 0; i < count; i++)
+  {
+    lights[i].radius = 0.35f;
+    lights[i].color = glm::vec3(rand() % 100, rand() % 100, rand() % 100) / 100.0f;
+  }
+
+  return lights;
+}
+
+// Moves the orbit lights to their positions at `time` seconds
+void updateOrbitLights(vector<PointLight> &lights, float time)
+{
+  for (size_t i = 0; i < lights.size(); i++)
+  {
+    float ring = 0.25f + 1.25f * (float)((i * 37) % 101) / 100.0f;
+    float angle = (float)i * 2.399963f + time * (0.2f + 0.3f * (float)(i % 7) / 7.0f);
+    float height = 0.3f * sin((float)i * 1.7f + time);
+    lights[i].position = glm::vec3(ring * cos(angle), height, ring * sin(angle));
+  }
+}
+
+// Binning time of 1 to 1024 random lights into the clusters of a camera, with
+// the SIMD sphere tests and with the scalar ones, plus how many lights each
+// cluster ends up with. The GPU side scales with the same per-cluster counts
+// (see --headless --lights N).
+// Usage: ./main --light-benchmark
+void runLightBenchmark()
+{
+  const int RUNS = 20;
+  char line[160];
+
+  Camera camera;
+  camera.initialize(nullptr, 1000, 1000);
+  camera.update(0.0f);
+
+  LightClusters clusters;
+
+  cout << LightClusters::TILES_X << "x" << LightClusters::TILES_Y << "x" << LightClusters::SLICES << " clusters, best of " << RUNS << " runs" << endl;
+  cout << "lights  simd ms   scalar ms  speedup  avg/cluster  max/cluster" << endl;
+
+  for (int count = 1; count <= 1024; count *= 2)
+  {
+    // Lights scattered in front of the camera, from 1 to 20 units away
+    vector<PointLight> lights(count);
+    srand(count);
+    for (int i = 0; i < count; i++)
+    {
+      lights[i].position = glm::vec3(rand() % 1000 / 100.0f - 5.0f, rand() % 1000 / 100.0f - 5.0f, 2.0f - rand() % 1900 / 100.0f);
+      lights[i].radius = 1.0f;
+      lights[i].color = glm::vec3(1.0f);
+    }
+
+    double best[2] = {1e30, 1e30};
+    int indexCount[2] = {0, 0};
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+      for (int run = 0; run < RUNS; run++)
+      {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        clusters.build(camera, lights, simd == 0);
+        best[simd] = min(best[simd], chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+      }
+      indexCount[simd] = clusters.getIndexCount();
+    }
+
+    snprintf(line, sizeof(line), "%-7d %-9.3f %-10.3f %-8.2f %-12.2f %d%s", count, best[0], best[1], best[1] / best[0],
+             (double)indexCount[0] / LightClusters::CLUSTER_COUNT, clusters.getMaxClusterLights(), indexCount[0] == indexCount[1] ? "" : "  MISMATCH");
+    cout << line << endl;
+  }
+}
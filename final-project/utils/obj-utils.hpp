@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <glad/glad.h>
 #include "stb_image.h"
@@ -236,6 +238,7 @@ vector<Material> readMTLFile(const string &assetsFolder, const string &mtlFileNa
       }
 
       currentMaterial = Material();
+      currentMaterial.illumination = 2;
       iss >> currentMaterial.name;
     }
     else if (keyword == "Ka")
@@ -269,6 +272,10 @@ vector<Material> readMTLFile(const string &assetsFolder, const string &mtlFileNa
       iss >> shininess;
       currentMaterial.shininess = shininess;
     }
+    else if (keyword == "illum")
+    {
+      iss >> currentMaterial.illumination;
+    }
   }
 
   // Needed to add the last material since no newmtl keyword is found
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchmark-utils.hpp"
+#include "camera.h"
+#include "mesh-simplifier.h"
+#include "obj-utils.hpp"
+#include "occlusion-culler.h"
+#include "triangle-bvh.h"
+
+using namespace std;
+
+float meshRadius(const vector<float> &vertices)
+{
+  float radius = 0.0f;
+  for (size_t v = 0; v + 2 < vertices.size(); v += MeshSimplifier::VERTEX_FLOATS)
+    radius = max(radius, glm::length(glm::vec3(vertices[v], vertices[v + 1], vertices[v + 2])));
+  return radius;
+}
+
+// Whether some point of the sphere facing the camera is in front of the
+// Earth, along rays against its full mesh. Samples the silhouette circle and
+// the center, so a sphere culled while any of them is visible was culled wrongly
+bool isSphereVisible(const TriangleBvh &earth, const glm::vec3 &eye, const glm::vec3 &center, float radius)
+{
+  const int SAMPLES = 32;
+  glm::vec3 toCenter = glm::normalize(center - eye);
+  glm::vec3 side = glm::normalize(glm::cross(toCenter, fabs(toCenter.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f)));
+  glm::vec3 up = glm::cross(side, toCenter);
+
+  for (int s = 0; s <= SAMPLES; s++)
+  {
+    float angle = 6.2831853f * s / SAMPLES;
+    glm::vec3 point = s == SAMPLES ? center - toCenter * radius : center + (side * cos(angle) + up * sin(angle)) * radius * 0.99f;
+    glm::vec3 direction = point - eye;
+    RayHit hit;
+    // The direction is not normalized: the point itself is at distance 1
+    if (!earth.raycast(eye, direction, 1.0f, hit))
+      return true;
+  }
+  return false;
+}
+
+// A scene where the Earth hides many small moons: `count` spheres a tenth of
+// the size of the Earth scattered in a shell from 1.2 to 4 Earth radii, seen from
+// 8 cameras around the Earth. The Earth is the only occluder, rasterized with
+// its simplest level of detail (1/8 of the triangles), and every moon left by
+// frustum culling is tested against the Hi-Z pyramid. Every moon in the
+// frustum is also checked with rays against the full Earth mesh, counting the
+// ones really hidden and the culled ones with a visible point (wrong).
+// Usage: ./main --occlusion-benchmark 10000
+void runOcclusionBenchmark(const string &earthPath, int count)
+{
+  const int RUNS = 5;
+  const int CAMERAS = 8;
+  const float MOON_SIZE = 0.1f;
+  char line[160];
+
+  vector<float> earthVertices = parseOBJFile(earthPath).vertices;
+  float earthRadius = meshRadius(earthVertices);
+  float moonRadius = earthRadius * MOON_SIZE;
+
+  MeshSimplifier simplifier;
+  simplifier.initialize(earthVertices);
+  simplifier.simplify(simplifier.getTriangleCount() / 8);
+  vector<float> occluder = simplifier.getVertices();
+
+  TriangleBvh earth;
+  earth.build(earthVertices);
+
+  srand(count);
+  vector<glm::vec3> centers(count);
+  for (int i = 0; i < count; i++)
+  {
+    glm::vec3 direction;
+    do
+      direction = glm::vec3(randomUnit(), randomUnit(), randomUnit()) * 2.0f - 1.0f;
+    while (glm::dot(direction, direction) > 1.0f || glm::dot(direction, direction) < 0.01f);
+    centers[i] = glm::normalize(direction) * earthRadius * (1.2f + 2.8f * randomUnit());
+  }
+
+  cout << count << " moons, occluder " << simplifier.getTriangleCount() << " of " << earth.getTriangleCount() << " Earth triangles, "
+       << OcclusionCuller::WIDTH << "x" << OcclusionCuller::HEIGHT << " Hi-Z" << endl;
+  cout << "camera  in frustum  hidden  occluded  wrong  | raster ms  pyramid ms  test ms" << endl;
+
+  OcclusionCuller culler;
+  int totalVisible = 0, totalHidden = 0, totalOccluded = 0;
+  for (int c = 0; c < CAMERAS; c++)
+  {
+    float angle = 6.2831853f * c / CAMERAS;
+    glm::vec3 eye = glm::vec3(cos(angle), 0.3f, sin(angle)) * earthRadius * 5.0f;
+
+    Camera camera;
+    camera.initialize(nullptr, 1000, 1000, 0.05f, 0.0f, -90.0f, glm::normalize(-eye), eye);
+    camera.setPerspective(45.0f, 0.1f, earthRadius * 20.0f);
+    camera.update(0.0f);
+
+    vector<int> visible;
+    for (int i = 0; i < count; i++)
+      if (Camera::isSphereInFrustum(camera.getFrustumPlanes(), centers[i], moonRadius))
+        visible.push_back(i);
+
+    double rasterTime = timeBest(RUNS, [&]()
+    {
+      culler.begin(camera.getViewProjectionMatrix());
+      culler.addOccluder(occluder, glm::mat4(1.0f));
+    });
+    double pyramidTime = timeBest(RUNS, [&]() { culler.buildPyramid(); });
+
+    vector<int> occluded;
+    double testTime = timeBest(RUNS, [&]()
+    {
+      occluded.clear();
+      for (size_t v = 0; v < visible.size(); v++)
+        if (culler.isSphereOccluded(centers[visible[v]], moonRadius))
+          occluded.push_back(visible[v]);
+    });
+
+    int hidden = 0, wrong = 0;
+    for (size_t v = 0, o = 0; v < visible.size(); v++)
+    {
+      bool isOccluded = o < occluded.size() && occluded[o] == visible[v];
+      o += isOccluded;
+      bool isVisible = isSphereVisible(earth, eye, centers[visible[v]], moonRadius);
+      hidden += !isVisible;
+      wrong += isOccluded && isVisible;
+    }
+
+    snprintf(line, sizeof(line), "%-7d %-11d %-7d %-9d %-6d | %-10.3f %-11.3f %.3f", c, (int)visible.size(), hidden, (int)occluded.size(), wrong,
+             rasterTime, pyramidTime, testTime);
+    cout << line << endl;
+    totalVisible += (int)visible.size();
+    totalHidden += hidden;
+    totalOccluded += (int)occluded.size();
+  }
+
+  snprintf(line, sizeof(line), "%d of %d draws culled (%.1f%%), %d really hidden", totalOccluded, totalVisible, 100.0f * totalOccluded / max(1, totalVisible),
+           totalHidden);
+  cout << line << endl;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchmark-utils.hpp"
+#include "camera.h"
+#include "obj-utils.hpp"
+#include "triangle-bvh.h"
+
+using namespace std;
+
+// Same hit, up to the distance: rays through a shared edge may report either triangle
+bool isSameHit(const RayHit &a, const RayHit &b)
+{
+  if ((a.triangle >= 0) != (b.triangle >= 0))
+    return false;
+  return a.triangle < 0 || fabs(a.distance - b.distance) <= 1e-4f * max(1.0f, a.distance);
+}
+
+// For each mesh, casts the primary rays of a SIZE x SIZE image from a camera
+// framing it, and times brute force (every triangle, on every 16th ray), the
+// binary BVH with one triangle at a time, the 4-wide BVH with 4 triangles per
+// test and 4-ray packets (2x2 pixel quads), checking that all of them find the
+// same hits.
+// Usage: ./main --ray-benchmark
+void runRayBenchmark(const vector<string> &paths)
+{
+  const int RUNS = 5;
+  const int SIZE = 512;
+  const int BRUTE_STRIDE = 16;
+  const int RAYS = SIZE * SIZE;
+  char line[160];
+
+  for (size_t m = 0; m < paths.size(); m++)
+  {
+    ParsedObj parsed = parseOBJFile(paths[m]);
+
+    TriangleBvh bvh;
+    double buildTime = timeBest(RUNS, [&]() { bvh.build(parsed.vertices); });
+    int triangles = bvh.getTriangleCount();
+
+    // Camera outside the bounding sphere of the mesh, looking at its center
+    glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+    for (size_t v = 0; v + 2 < parsed.vertices.size(); v += TriangleBvh::VERTEX_FLOATS)
+    {
+      glm::vec3 position(parsed.vertices[v], parsed.vertices[v + 1], parsed.vertices[v + 2]);
+      boundsMin = glm::min(boundsMin, position);
+      boundsMax = glm::max(boundsMax, position);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = glm::length(boundsMax - center);
+    glm::vec3 front = glm::normalize(glm::vec3(-0.3f, -0.4f, -1.0f));
+
+    Camera camera;
+    camera.initialize(nullptr, SIZE, SIZE, 0.05f, 0.0f, -90.0f, front, center - front * radius * 2.5f);
+
+    vector<glm::vec3> origins(RAYS), directions(RAYS);
+    for (int y = 0; y < SIZE; y++)
+      for (int x = 0; x < SIZE; x++)
+        camera.getRay(x + 0.5f, y + 0.5f, SIZE, SIZE, origins[y * SIZE + x], directions[y * SIZE + x]);
+
+    vector<RayHit> brute(RAYS), scalar(RAYS), simd(RAYS), packet(RAYS);
+
+    double bruteTime = timeBest(1, [&]()
+    {
+      for (int r = 0; r < RAYS; r += BRUTE_STRIDE)
+      {
+        brute[r].triangle = -1;
+        brute[r].distance = FLT_MAX;
+        for (int t = 0; t < triangles; t++)
+        {
+          const float *v0 = &parsed.vertices[t * 3 * TriangleBvh::VERTEX_FLOATS];
+          const float *v1 = v0 + TriangleBvh::VERTEX_FLOATS, *v2 = v1 + TriangleBvh::VERTEX_FLOATS;
+          float u, v;
+          float distance = TriangleBvh::intersectTriangle(origins[r], directions[r], glm::vec3(v0[0], v0[1], v0[2]), glm::vec3(v1[0], v1[1], v1[2]),
+                                                          glm::vec3(v2[0], v2[1], v2[2]), brute[r].distance, u, v);
+          if (distance >= 0.0f)
+          {
+            brute[r].triangle = t;
+            brute[r].distance = distance;
+          }
+        }
+      }
+    });
+    double scalarTime = timeBest(RUNS, [&]()
+    {
+      for (int r = 0; r < RAYS; r++)
+        bvh.raycastScalar(origins[r], directions[r], FLT_MAX, scalar[r]);
+    });
+    double simdTime = timeBest(RUNS, [&]()
+    {
+      for (int r = 0; r < RAYS; r++)
+        bvh.raycast(origins[r], directions[r], FLT_MAX, simd[r]);
+    });
+
+    // Packets of 2x2 neighboring pixels, stored back in image order
+    double packetTime = timeBest(RUNS, [&]()
+    {
+      for (int y = 0; y < SIZE; y += 2)
+        for (int x = 0; x < SIZE; x += 2)
+        {
+          int rays[4] = {y * SIZE + x, y * SIZE + x + 1, (y + 1) * SIZE + x, (y + 1) * SIZE + x + 1};
+          glm::vec3 quadOrigins[4], quadDirections[4];
+          RayHit quadHits[4];
+          for (int i = 0; i < 4; i++)
+          {
+            quadOrigins[i] = origins[rays[i]];
+            quadDirections[i] = directions[rays[i]];
+          }
+          bvh.raycastPacket(quadOrigins, quadDirections, FLT_MAX, quadHits);
+          for (int i = 0; i < 4; i++)
+            packet[rays[i]] = quadHits[i];
+        }
+    });
+
+    int hits = 0, scalarMismatches = 0, simdMismatches = 0, packetMismatches = 0;
+    for (int r = 0; r < RAYS; r++)
+    {
+      hits += simd[r].triangle >= 0;
+      const RayHit &reference = r % BRUTE_STRIDE == 0 ? brute[r] : scalar[r];
+      scalarMismatches += !isSameHit(reference, scalar[r]);
+      simdMismatches += !isSameHit(reference, simd[r]);
+      packetMismatches += !isSameHit(reference, packet[r]);
+    }
+
+    snprintf(line, sizeof(line), "%s: %d triangles, %d 4-wide nodes (%d binary), build %.3f ms, %d of %d rays hit", paths[m].c_str(), triangles,
+             bvh.getNodeCount(), bvh.getBinaryBvh().getNodeCount(), buildTime, hits, RAYS);
+    cout << line << endl;
+
+    // Brute force only ran on every BRUTE_STRIDE-th ray: its time is scaled to the whole image
+    const char *names[4] = {"brute", "scalar", "simd", "packet"};
+    double times[4] = {bruteTime * BRUTE_STRIDE, scalarTime, simdTime, packetTime};
+    int mismatches[4] = {0, scalarMismatches, simdMismatches, packetMismatches};
+    for (int i = 0; i < 4; i++)
+    {
+      double mrays = RAYS / (times[i] * 1000.0);
+      snprintf(line, sizeof(line), "  %-7s %9.3f ms  %8.2f Mrays/s  (%7.1fx brute, %4.2fx scalar)", names[i], times[i], mrays, times[0] / times[i], scalarTime / times[i]);
+      cout << line;
+      if (mismatches[i] > 0)
+        cout << "  MISMATCH " << mismatches[i];
+      cout << endl;
+    }
+  }
+}
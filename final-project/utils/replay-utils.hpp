@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+
+using namespace std;
+
+struct ReplayEvent
+{
+  int frame;
+  bool isKey;
+  int key;
+  int action;
+  double x, y;
+};
+
+struct KeyName
+{
+  int key;
+  const char *name;
+};
+
+// GLFW names (without the GLFW_KEY_ prefix) of the keys that are not a letter,
+// a digit or F1-F25. Any other key is written as its GLFW code
+const KeyName KEY_NAMES[] = {
+    {GLFW_KEY_SPACE, "SPACE"}, {GLFW_KEY_ESCAPE, "ESCAPE"}, {GLFW_KEY_ENTER, "ENTER"}, {GLFW_KEY_TAB, "TAB"},
+    {GLFW_KEY_BACKSPACE, "BACKSPACE"}, {GLFW_KEY_INSERT, "INSERT"}, {GLFW_KEY_DELETE, "DELETE"}, {GLFW_KEY_RIGHT, "RIGHT"},
+    {GLFW_KEY_LEFT, "LEFT"}, {GLFW_KEY_DOWN, "DOWN"}, {GLFW_KEY_UP, "UP"}, {GLFW_KEY_PAGE_UP, "PAGE_UP"},
+    {GLFW_KEY_PAGE_DOWN, "PAGE_DOWN"}, {GLFW_KEY_HOME, "HOME"}, {GLFW_KEY_END, "END"}, {GLFW_KEY_LEFT_SHIFT, "LEFT_SHIFT"},
+    {GLFW_KEY_LEFT_CONTROL, "LEFT_CONTROL"}, {GLFW_KEY_LEFT_ALT, "LEFT_ALT"}, {GLFW_KEY_RIGHT_SHIFT, "RIGHT_SHIFT"},
+    {GLFW_KEY_RIGHT_CONTROL, "RIGHT_CONTROL"}, {GLFW_KEY_RIGHT_ALT, "RIGHT_ALT"},
+};
+
+// Name of a key in replay scripts: the letter or digit itself, F1-F25, a
+// name from KEY_NAMES or else the GLFW code
+string keyToName(int key)
+{
+  if ((key >= GLFW_KEY_A && key <= GLFW_KEY_Z) || (key >= GLFW_KEY_0 && key <= GLFW_KEY_9))
+    return string(1, (char)key);
+  if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F25)
+    return "F" + to_string(key - GLFW_KEY_F1 + 1);
+  for (const KeyName &name : KEY_NAMES)
+    if (name.key == key)
+      return name.name;
+  return to_string(key);
+}
+
+// Inverse of keyToName, case insensitive and also accepting the GLFW_KEY_
+// prefix. A single digit is the digit key, longer numbers are GLFW codes
+int nameToKey(string name)
+{
+  for (size_t i = 0; i < name.size(); i++)
+    name[i] = toupper(name[i]);
+  if (name.compare(0, 9, "GLFW_KEY_") == 0)
+    name = name.substr(9);
+
+  if (name.size() == 1 && isalnum(name[0]))
+    return name[0];
+  if (name.size() > 1 && name.find_first_not_of("0123456789") == string::npos)
+    return atoi(name.c_str());
+  if (name.size() > 1 && name[0] == 'F' && name.find_first_not_of("0123456789", 1) == string::npos)
+  {
+    int number = atoi(name.c_str() + 1);
+    if (number >= 1 && number <= 25)
+      return GLFW_KEY_F1 + number - 1;
+  }
+  for (const KeyName &keyName : KEY_NAMES)
+    if (name == keyName.name)
+      return keyName.key;
+  return GLFW_KEY_UNKNOWN;
+}
+
+// Reads a recorded input script (see ReplayRecorder). Each line is an event
+// applied at the beginning of the given frame, lines starting with # are comments:
+//
+//   <frame> key <key> <press|release|repeat>    (key as in keyToName: W, ESCAPE, LEFT, F1, GLFW_KEY_UP or a code)
+//   <frame> mouse <x> <y>
+vector<ReplayEvent> loadReplayScript(const string &path)
+{
+  vector<ReplayEvent> events;
+  ifstream file(path.c_str());
+
+  if (!file.is_open())
+  {
+    cout << "Failed to open file: " << path << endl;
+    return events;
+  }
+
+  string line;
+  while (getline(file, line))
+  {
+    istringstream iss(line);
+    ReplayEvent event;
+    string type;
+
+    if (line.empty() || line[0] == '#' || !(iss >> event.frame >> type))
+      continue;
+
+    if (type == "key")
+    {
+      string key, action;
+      iss >> key >> action;
+
+      event.isKey = true;
+      event.key = nameToKey(key);
+      event.action = action == "release" ? GLFW_RELEASE : action == "repeat" ? GLFW_REPEAT : GLFW_PRESS;
+
+      if (event.key == GLFW_KEY_UNKNOWN)
+      {
+        cout << "Unknown replay key: " << line << endl;
+        continue;
+      }
+    }
+    else if (type == "mouse")
+    {
+      event.isKey = false;
+      iss >> event.x >> event.y;
+    }
+    else
+    {
+      cout << "Unknown replay event: " << line << endl;
+      continue;
+    }
+
+    events.push_back(event);
+  }
+
+  return events;
+}
+
+// Writes the key and cursor callbacks of a run as a replay script, each event
+// with the frame in which it arrived. The last line is a comment with the
+// number of frames and the average frame time, the --frames and --step that
+// replay the recording in headless mode.
+//   recorder.open("replays/recorded.txt");
+//   recorder.setFrame(frame);               (each frame, before polling events)
+//   recorder.key(key, action);              (from the callbacks)
+//   recorder.addTime(realDeltaTime);        (each frame)
+//   recorder.close();
+struct ReplayRecorder
+{
+  ofstream file;
+  int frame = 0;
+  double seconds = 0.0;
+
+  bool open(const string &path)
+  {
+    file.open(path.c_str());
+    if (!file.is_open())
+    {
+      cout << "Failed to open file: " << path << endl;
+      return false;
+    }
+    // Cursor positions keep their fractional part (the disabled cursor moves in sub-pixels)
+    file.precision(10);
+    file << "# Recorded with --record" << endl;
+    file << "# <frame> key <key> <press|release|repeat>" << endl;
+    file << "# <frame> mouse <x> <y>" << endl;
+    return true;
+  }
+
+  bool isRecording() const { return file.is_open(); }
+
+  void setFrame(int frame) { this->frame = frame; }
+
+  void addTime(double deltaTime) { seconds += deltaTime; }
+
+  void key(int key, int action)
+  {
+    if (isRecording())
+      file << frame << " key " << keyToName(key) << " " << (action == GLFW_RELEASE ? "release" : action == GLFW_REPEAT ? "repeat" : "press") << endl;
+  }
+
+  void mouse(double x, double y)
+  {
+    if (isRecording())
+      file << frame << " mouse " << x << " " << y << endl;
+  }
+
+  void close(int frames)
+  {
+    if (!isRecording())
+      return;
+    file << "# " << frames << " frames: --frames " << frames << " --step " << seconds / max(frames, 1) << endl;
+    file.close();
+  }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "benchmark-utils.hpp"
+#include "scene-graph.h"
+#include "transform-system.h"
+
+using namespace std;
+
+// Builds `nodes` nodes as chains of `depth` nodes (depth 1 is a single root
+// with every other node as its child) in both a scene graph and a flat
+// transform system with parent indices, and times the world matrix updates
+void benchmarkHierarchy(const string &name, int nodes, int depth)
+{
+  const int RUNS = 10;
+  const glm::vec3 offset = glm::vec3(0.0f, 0.0f, 1.0f);
+
+  SceneGraph graph;
+  TransformSystem flat;
+  vector<int> roots;
+  int leaf = -1;
+
+  for (int node = 0; node < nodes; node++)
+  {
+    bool root = depth > 1 ? node % depth == 0 : node == 0;
+    int parent = root ? -1 : (depth > 1 ? node - 1 : 0);
+
+    graph.createNode(parent, offset, glm::vec3(0.99f));
+    flat.create(offset, glm::vec3(0.99f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), parent);
+
+    if (root)
+      roots.push_back(node);
+    else
+      leaf = node;
+  }
+
+  vector<glm::mat4> models(nodes);
+  const glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f);
+  char line[128];
+
+  // Every node walks its parent chain again (what TransformSystem does on its own)
+  double flatTime = timeBest(RUNS, [&]() { flat.computeModels(0, nodes, models.data()); });
+  double fullTime = timeBest(RUNS, [&]() { graph.updateAllWorld(); });
+  int fullCount = graph.getLastUpdateCount();
+  double cleanTime = timeBest(RUNS, [&]() { graph.updateWorld(); });
+  int cleanCount = graph.getLastUpdateCount();
+  double rootTime = timeBest(RUNS, [&]() { graph.rotate(roots[0], 0.01f, axis); graph.updateWorld(); });
+  int rootCount = graph.getLastUpdateCount();
+  double leafTime = timeBest(RUNS, [&]() { graph.rotate(leaf, 0.01f, axis); graph.updateWorld(); });
+  int leafCount = graph.getLastUpdateCount();
+
+  cout << name << ": " << nodes << " nodes, " << roots.size() << " roots, depth " << max(depth, 2) << endl;
+  snprintf(line, sizeof(line), "  parent chain walk   %9.3f ms  %d nodes", flatTime, nodes);
+  cout << line << endl;
+  snprintf(line, sizeof(line), "  graph, all dirty    %9.3f ms  %d nodes", fullTime, fullCount);
+  cout << line << endl;
+  snprintf(line, sizeof(line), "  graph, one root     %9.3f ms  %d nodes", rootTime, rootCount);
+  cout << line << endl;
+  snprintf(line, sizeof(line), "  graph, one leaf     %9.3f ms  %d nodes", leafTime, leafCount);
+  cout << line << endl;
+  snprintf(line, sizeof(line), "  graph, nothing      %9.3f ms  %d nodes", cleanTime, cleanCount);
+  cout << line << endl;
+}
+
+// Compares the scene graph update with the flat parent chain walk on a deep
+// hierarchy (chains of 100 nodes) and a wide one (one root, every other node
+// its child).
+// Usage: ./main --scene-benchmark 100000
+void runSceneBenchmark(int nodes)
+{
+  benchmarkHierarchy("deep", nodes, 100);
+  benchmarkHierarchy("wide", nodes, 1);
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 
 const std::string WHITESPACE = " \n\r\t\f\v";
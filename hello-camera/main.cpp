@@ -23,6 +23,8 @@ using namespace std;
 #include "stb_image.h"
 #include "Shader.h"
 #include "camera.h"
+#include "frame-clock.h"
+#include "profiler.h"
 
 const string ASSETS_FOLDER = "../common/3d-models/suzanne/";
 const string OBJ_FILE_PATH = ASSETS_FOLDER + "SuzanneTriTextured.obj";
@@ -134,6 +136,8 @@ std::string trim(const std::string &s)
 }
 
 Camera camera;
+FrameClock frameClock;
+Profiler profiler;
 
 int main()
 {
@@ -210,11 +214,15 @@ int main()
 
   glEnable(GL_DEPTH_TEST);
 
+  profiler.initialize();
+
   // Loop da aplicação - "game loop"
   while (!glfwWindowShouldClose(window))
   {
     // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
     glfwPollEvents();
+    frameClock.tick();
+    profiler.beginFrame();
 
     // Limpa o buffer de cor
     glClearColor(0.08f, 0.08f, 0.08f, 1.0f); // cor de fundo
@@ -223,7 +231,7 @@ int main()
     glLineWidth(10);
     glPointSize(20);
 
-    camera.update();
+    camera.update(frameClock.getDeltaTime());
 
     float angle = (GLfloat)glfwGetTime();
 
@@ -235,17 +243,24 @@ int main()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureId);
 
+    profiler.beginGPU("draw");
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, verticesCount);
     // glDrawArrays(GL_POINTS, 0, verticesCount);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
+    profiler.endGPU();
+
+    // Sobrepõe os tempos de CPU/GPU de cada escopo no canto da tela
+    profiler.drawOverlay(width, height);
+    profiler.endFrame();
 
     // Troca os buffers da tela
     glfwSwapBuffers(window);
   }
   // Pede pra OpenGL desalocar os buffers
   glDeleteVertexArrays(1, &VAO);
+  profiler.release();
   // Finaliza a execução da GLFW, limpando os recursos alocados por ela
   glfwTerminate();
   return 0;
@@ -25,6 +25,8 @@ using namespace std;
 #include "camera.h"
 #include "bezier.h"
 #include "mesh.h"
+#include "frame-clock.h"
+#include "profiler.h"
 
 const string ASSETS_FOLDER = "../common/3d-models/suzanne/";
 const string OBJ_FILE_PATH = ASSETS_FOLDER + "SuzanneTriTextured.obj";
@@ -137,6 +139,8 @@ std::string trim(const std::string &s)
 }
 
 Camera camera;
+FrameClock frameClock;
+Profiler profiler;
 
 int main()
 {
@@ -202,16 +206,18 @@ int main()
 	bezier.setControlPoints(controlPoints);
 	bezier.setShader(&shader);
 	bezier.generateCurve(100);
-	int nbCurvePoints = bezier.getNbCurvePoints();
-	int i = 0;
 
   glEnable(GL_DEPTH_TEST);
 
+  profiler.initialize();
+
   // Loop da aplicação - "game loop"
   while (!glfwWindowShouldClose(window))
   {
     // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
     glfwPollEvents();
+    frameClock.tick();
+    profiler.beginFrame();
 
     // Limpa o buffer de cor
     glClearColor(0.08f, 0.08f, 0.08f, 1.0f); // cor de fundo
@@ -220,20 +226,27 @@ int main()
     glLineWidth(10);
     glPointSize(20);
 
-    camera.update();
+    camera.update(frameClock.getDeltaTime());
 
-		glm::vec3 pointOnCurve = bezier.getPointOnCurve(i);
+		// Percorre a curva inteira a cada 10 segundos, independente da taxa de quadros
+		glm::vec3 pointOnCurve = bezier.evaluate(frameClock.getTime() / 10.0);
 		suzanne.updatePosition(pointOnCurve);
-		suzanne.update();
+		suzanne.update(frameClock.getDeltaTime());
+
+		profiler.beginGPU("suzanne.draw");
 		suzanne.draw(material);
+		profiler.endGPU();
 
-    i = (i + 1) % nbCurvePoints;
+		// Sobrepõe os tempos de CPU/GPU de cada escopo no canto da tela
+		profiler.drawOverlay(width, height);
+		profiler.endFrame();
 
     glfwSwapBuffers(window);
   }
 
 
   glDeleteVertexArrays(1, &VAO);
+  profiler.release();
   glfwTerminate();
   return 0;
 }